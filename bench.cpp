@@ -0,0 +1,306 @@
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+
+#include <stb_image.h>
+#include <stb_image_write.h>
+#include "src/includes.h"
+#include "src/global.h"
+#include "src/utils.h"
+#include "src/physics.h"
+#include "src/loader.h"
+#include "src/core.h"
+#include "src/headless.h"
+#include "src/streaming.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Microbenchmarks, "make bench". Each benchmark;
+ - Runs for dev::BENCH_WARMUP_MS first, and to calibrate how many operations make a
+   repetition last at least dev::BENCH_MIN_REPETITION_MS.
+ - Then times dev::BENCH_REPETITIONS repetitions. The median per-operation time is
+   what gets compared, it ignores the odd preempted repetition.
+Results are JSON, one benchmark per line. "--compare <baseline>" flags every benchmark
+whose median is more than dev::BENCH_REGRESSION_THRESHOLD slower, and whose fastest
+repetition is still slower than the baseline's median, then exits with 1.
+\* -------------------------------------------------------------------------------- */
+
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchResult {
+	std::string name;
+	size_t operations; //Per repetition.
+	double median, min, max, deviation; //Nanoseconds per operation.
+};
+
+static std::vector<BenchResult> results;
+static std::string filter;
+
+
+
+template<typename T>
+static inline void keep(const T& value) {
+	asm volatile("" : : "r,m"(value) : "memory"); //Stops the optimiser dropping a result.
+}
+
+
+static void run(const std::string& name, const std::function<void()>& operation) {
+	if (!filter.empty() && (name.find(filter) == std::string::npos)) {return;}
+
+	//Warmup, counting how many operations fit.
+	size_t operations = 0u;
+	Clock::time_point warmupStart = Clock::now();
+	double warmupMS = 0.0d;
+	while ((warmupMS < dev::BENCH_WARMUP_MS) || (operations == 0u)) {
+		operation();
+		operations++;
+		warmupMS = std::chrono::duration<double, std::milli>(Clock::now() - warmupStart).count();
+	}
+	size_t perRepetition = std::max<size_t>(1u, static_cast<size_t>(std::ceil(operations * (dev::BENCH_MIN_REPETITION_MS / warmupMS))));
+
+	std::vector<double> times(dev::BENCH_REPETITIONS);
+	for (double& time : times) {
+		Clock::time_point start = Clock::now();
+		for (size_t index=0; index<perRepetition; index++) {operation();}
+		time = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / perRepetition;
+	}
+	std::sort(times.begin(), times.end());
+
+	double mean = std::accumulate(times.begin(), times.end(), 0.0d) / times.size();
+	double variance = 0.0d;
+	for (double time : times) {variance += (time - mean) * (time - mean);}
+	BenchResult result = {name, perRepetition, times[times.size() / 2u], times.front(), times.back(), std::sqrt(variance / times.size())};
+	results.push_back(result);
+	std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(1)
+			  << std::setw(14) << result.median << " ns/op  (min " << result.min << ", +/-" << (100.0d * result.deviation / mean) << "%)" << std::defaultfloat << std::endl;
+}
+
+
+
+
+//////// CATALOGS ////////
+
+static std::string catalogXML(size_t bodyCount, size_t shipCount) {
+	//One star, a tenth planets, the rest satellites spread over the planets. Every route visits 3 planets.
+	size_t planetCount = std::max<size_t>(1u, bodyCount / 10u);
+	size_t satelliteCount = (bodyCount > planetCount + 1u) ? (bodyCount - planetCount - 1u) : 0u;
+	std::ostringstream xml;
+	xml << "<?xml version=\"1.1\" encoding=\"UTF-8\"?>\n<meta simSpeed=\"1\" />\n<bodies>\n";
+	xml << "<star name=\"Star\" colour=\"255 255 255\" position=\"0 0\" radius=\"696.340\">\n";
+	for (size_t planet=0; planet<planetCount; planet++) {
+		xml << "<planet name=\"P" << planet << "\" colour=\"127 127 127\" radius=\"6.0\" orbitalRadius=\"" << (50000.0d + (planet * 1000.0d)) << "\" orbitalPeriod=\"" << (88.0d + planet) << "\">\n";
+		for (size_t satellite=planet; satellite<satelliteCount; satellite+=planetCount) {
+			xml << "<satellite name=\"S" << satellite << "\" colour=\"96 96 96\" radius=\"1.0\" orbitalRadius=\"" << (300.0d + satellite) << "\" orbitalPeriod=\"" << (1.0d + (satellite % 30u)) << "\" />\n";
+		}
+		xml << "</planet>\n";
+	}
+	xml << "</star>\n</bodies>\n<camera><view name=\"All\" body=\"Star\" scale=\"0.000001\" offset=\"0 0\" /></camera>\n<routes>\n";
+	for (size_t ship=0; ship<shipCount; ship++) {
+		xml << "<route name=\"R" << ship << "\" locations=\"P" << (ship % planetCount) << ",P" << ((ship * 7u + 1u) % planetCount) << ",P" << ((ship * 13u + 2u) % planetCount) << "\" />\n";
+	}
+	xml << "</routes>\n<spacecraft>\n";
+	for (size_t ship=0; ship<shipCount; ship++) {xml << "<ship name=\"Ship" << ship << "\" route=\"R" << ship << "\" />\n";}
+	xml << "</spacecraft>\n";
+	return xml.str();
+}
+
+
+static std::string writeCatalog(size_t bodyCount, size_t shipCount) {
+	std::filesystem::path path = std::filesystem::temp_directory_path() / ("starbound-bench-" + std::to_string(bodyCount) + "-" + std::to_string(shipCount) + ".xml");
+	std::ofstream(path) << catalogXML(bodyCount, shipCount);
+	return path.string();
+}
+
+
+static void loadCatalog(std::string& path) {
+	//Quietly, the loader reports every view.
+	std::streambuf* console = std::cout.rdbuf(nullptr);
+	core::load(path);
+	std::cout.rdbuf(console);
+}
+
+//////// CATALOGS ////////
+
+
+
+
+//////// BENCHMARKS ////////
+
+static void benchPhysics() {
+	for (size_t bodyCount : {10u, 100u, 1000u, 10000u}) {
+		std::string path = writeCatalog(bodyCount, 0u);
+		loadCatalog(path);
+		time_t UTC = 1760850000;
+		run("bodies::evaluate/" + std::to_string(bodyCount), [&]() {
+			bodies::evaluate(UTC += 60, data::bodies);
+			keep(data::bodies.back().position);
+		});
+	}
+
+	for (size_t shipCount : {10u, 100u, 1000u}) {
+		std::string path = writeCatalog(100u, shipCount);
+		loadCatalog(path);
+		time_t UTC = 1760850000;
+		run("spacecraft::evaluate/" + std::to_string(shipCount), [&]() {
+			spacecraft::evaluate(UTC += 60, data::spacecraft);
+			keep(data::spacecraft.back().position);
+		});
+	}
+}
+
+
+static void benchLoader() {
+	for (size_t bodyCount : {10u, 100u, 1000u}) {
+		std::string path = writeCatalog(bodyCount, bodyCount / 10u);
+		run("loader::loadXMLdata/" + std::to_string(bodyCount), [&]() {loadCatalog(path);});
+	}
+
+	for (size_t bodyCount : {10u, 100u, 1000u, 10000u}) {
+		std::string path = writeCatalog(bodyCount, 0u);
+		loadCatalog(path);
+		std::vector<std::string> names;
+		for (const structs::CelestialBody& body : data::bodies) {names.push_back(body.name);}
+		std::shuffle(names.begin(), names.end(), std::mt19937(12345u));
+		size_t next = 0u;
+		run("loader::findBody/" + std::to_string(bodyCount), [&]() {
+			keep(loader::findBody(names[next++ % names.size()]));
+		});
+	}
+}
+
+
+static void benchUploads() {
+	//CPU cost on the render thread, as a frame pays it. Nothing reads the buffers, so the GPU is never behind.
+	for (size_t count : {100u, 10000u, 1000000u}) {
+		std::vector<glm::ivec2> positions(count, glm::ivec2(1, 2));
+		size_t bytes = count * sizeof(glm::ivec2);
+
+		streaming::StreamBuffer stream;
+		stream.create(GL_SHADER_STORAGE_BUFFER, bytes, bindings::BODY_POSITIONS);
+		run("StreamBuffer upload/" + std::to_string(count), [&]() {
+			std::memcpy(stream.map(), positions.data(), bytes);
+			stream.commit();
+		});
+		glFinish();
+		stream.destroy();
+
+		GLuint SSBO;
+		glGenBuffers(1, &SSBO);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_DYNAMIC_DRAW);
+		run("glBufferSubData upload/" + std::to_string(count), [&]() {
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, positions.data());
+		});
+		glFinish();
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glDeleteBuffers(1, &SSBO);
+	}
+}
+
+//////// BENCHMARKS ////////
+
+
+
+
+//////// RESULTS ////////
+
+static void writeResults(const std::string& path) {
+	std::ofstream file(path);
+	if (!file) {std::cerr << "Could not write results [" << path << "]" << std::endl; return;}
+	file << std::fixed << std::setprecision(3);
+	file << "{\"warmupMS\":" << dev::BENCH_WARMUP_MS << ",\"repetitions\":" << dev::BENCH_REPETITIONS << ",\"benchmarks\":[\n";
+	for (size_t index=0; index<results.size(); index++) {
+		const BenchResult& result = results[index];
+		file << "{\"name\":\"" << result.name << "\",\"operations\":" << result.operations << ",\"median\":" << result.median
+			 << ",\"min\":" << result.min << ",\"max\":" << result.max << ",\"deviation\":" << result.deviation << "}"
+			 << ((index + 1u < results.size()) ? ",\n" : "\n");
+	}
+	file << "]}\n";
+	std::cout << "Results saved as : [" << path << "]" << std::endl;
+}
+
+
+static std::unordered_map<std::string, double> readBaseline(const std::string& path) {
+	//Only reads the files written above; One benchmark per line.
+	std::unordered_map<std::string, double> medians;
+	std::ifstream file(path);
+	if (!file) {throw std::runtime_error("Could not read baseline [" + path + "]");}
+	std::regex entry("\"name\":\"([^\"]+)\".*\"median\":([0-9.eE+-]+)");
+	std::string line;
+	std::smatch match;
+	while (std::getline(file, line)) {
+		if (std::regex_search(line, match, entry)) {medians[match[1]] = std::stod(match[2]);}
+	}
+	return medians;
+}
+
+
+static int compare(const std::string& baselinePath) {
+	std::unordered_map<std::string, double> baseline = readBaseline(baselinePath);
+	unsigned int regressions = 0u;
+	std::cout << std::endl << "Against [" << baselinePath << "], threshold " << (dev::BENCH_REGRESSION_THRESHOLD * 100.0d) << "%;" << std::endl;
+	for (const BenchResult& result : results) {
+		auto found = baseline.find(result.name);
+		if (found == baseline.end()) {std::cout << std::left << std::setw(40) << result.name << " new" << std::endl; continue;}
+		double change = (result.median / found->second) - 1.0d;
+		bool slower = (change > dev::BENCH_REGRESSION_THRESHOLD);
+		bool confirmed = slower && (result.min > found->second); //Even the fastest repetition, otherwise it is likely noise.
+		const char* verdict = (confirmed) ? "REGRESSION" : ((slower) ? "slower (noisy)" : ((change < -dev::BENCH_REGRESSION_THRESHOLD) ? "faster" : ""));
+		if (confirmed) {regressions++;}
+		std::cout << std::left << std::setw(40) << result.name << std::right << std::fixed << std::setprecision(1)
+				  << std::setw(14) << found->second << " -> " << std::setw(12) << result.median << " ns/op  " << std::showpos << (change * 100.0d) << "%" << std::noshowpos << "  " << verdict << std::defaultfloat << std::endl;
+	}
+	std::cout << regressions << " regression(s)." << std::endl;
+	return (regressions > 0u) ? 1 : 0;
+}
+
+//////// RESULTS ////////
+
+
+
+
+int main(int argc, char** argv) {
+	try { //Catch exceptions
+
+	//Command line;
+	//  --out <file>        Results JSON, defaults to "saved.bench/<timestamp>.json".
+	//  --compare <file>    Baseline results to compare against. Exits with 1 on any regression.
+	//  --filter <text>     Only benchmarks with this in their name.
+	//  --no-gl             Skip the benchmarks which need an OpenGL context.
+	std::string outPath, baselinePath;
+	bool useGL = true;
+	for (int argIndex=1; argIndex<argc; argIndex++) {
+		std::string arg = argv[argIndex];
+		bool hasValue = (argIndex + 1 < argc) && (argv[argIndex + 1][0] != '-');
+		if ((arg == "--out") && hasValue) {outPath = argv[++argIndex];}
+		else if ((arg == "--compare") && hasValue) {baselinePath = argv[++argIndex];}
+		else if ((arg == "--filter") && hasValue) {filter = argv[++argIndex];}
+		else if (arg == "--no-gl") {useGL = false;}
+		else {std::cout << "Unknown argument: " << arg << std::endl;}
+	}
+	if (outPath.empty()) {
+		std::filesystem::create_directories("saved.bench");
+		outPath = (std::filesystem::path("saved.bench") / (utils::getTimestampStrPrecise() + ".json")).string();
+	}
+
+	benchPhysics();
+	benchLoader();
+	if (useGL) {
+		headless::initialiseContext();
+		benchUploads();
+		headless::destroyContext();
+	}
+
+	writeResults(outPath);
+	return (baselinePath.empty()) ? 0 : compare(baselinePath);
+
+
+	//Catch exceptions.
+	} catch (const std::exception& e) {
+		std::cerr << "An exception was thrown: " << e.what() << std::endl;
+		return 1;
+	}
+}
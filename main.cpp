@@ -6,9 +6,29 @@
 #include "src/includes.h"
 #include "src/global.h"
 #include "src/utils.h"
+#include "src/glutils.h"
 #include "src/graphics.h"
 #include "src/physics.h"
 #include "src/loader.h"
+#include "src/ephemeris.h"
+#include "src/headless.h"
+#include "src/capture.h"
+#include "src/recorder.h"
+#include "src/textures.h"
+#include "src/trails.h"
+#include "src/text.h"
+#include "src/pacer.h"
+#include "src/simulation.h"
+#include "src/profiler.h"
+#include "src/framestats.h"
+#include "src/telemetry.h"
+#include "src/broadcast.h"
+#include "src/journal.h"
+#include "src/viewports.h"
+#include "src/redraw.h"
+#include "src/clusters.h"
+#include "src/heatmap.h"
+#include "src/schedule.h"
 using namespace std;
 using namespace utils;
 using namespace glm;
@@ -28,17 +48,32 @@ void framebufferSizeCallback(GLFWwindow* Window, int width, int height) {
 		glm::min(width, display::RENDER_RESOLUTION.x),
 		glm::min(height, display::RENDER_RESOLUTION.y)
 	);
+	redraw::mark(redraw::RR_WINDOW);
 }
 
 
 
+bool continuousCapture = false; //Save every frame.
+unsigned int recordFrames = 0u; //--record countdown; Cleared once [R] takes over the recording.
+
+
+void releaseGraphics() {
+	//Every subsystem's streams, before the context they belong to is destroyed.
+	clusters::release();
+	viewports::release();
+	text::release();
+	trails::release();
+	ephemeris::release();
+}
+
+
 bool pressedThisFrame(int glfwEnum) {
 	return keyMap[glfwEnum] && !previousKeyMap[glfwEnum];
 }
 
 
 void handleInputs() {
-	glfwPollEvents();
+	redraw::wait(); //Sleeps until an event or simulation change, unless a frame is already due.
 
 	//Get keyboard inputs for this frame
 	previousKeyMap = keyMap; //Save last frame's inputs.
@@ -51,6 +86,26 @@ void handleInputs() {
 
 	if (pressedThisFrame(GLFW_KEY_E)) {graphics::view::viewNext();}
 	if (pressedThisFrame(GLFW_KEY_Q)) {graphics::view::viewPrevious();}
+	if (pressedThisFrame(GLFW_KEY_R)) {
+		recordFrames = 0u;
+		if (recorder::recording()) {recorder::stop();}
+		else {recorder::start(currentWindowResolution, utils::getTimestamp(), sim::RECORDER_TIME_STEP);}
+	}
+	if (pressedThisFrame(GLFW_KEY_F3)) {
+		continuousCapture = !continuousCapture;
+		std::cout << "Continuous capture " << ((continuousCapture) ? "started" : "stopped") << ". (" << capture::droppedCaptures() << " frames dropped so far)" << std::endl;
+	}
+	if (pressedThisFrame(GLFW_KEY_F4)) {profiler::traceRecent(); /* The frames just seen, already recorded. */}
+	if (pressedThisFrame(GLFW_KEY_F5)) {framestats::writeSummary();}
+	if (pressedThisFrame(GLFW_KEY_B)) {schedule::toggle();}
+	if (heatmap::active()) {
+		if (pressedThisFrame(GLFW_KEY_H)) {heatmap::toggle();}
+		if (pressedThisFrame(GLFW_KEY_F6)) {heatmap::exportImage();}
+	}
+	if (journal::replaying()) {
+		if (pressedThisFrame(GLFW_KEY_PAGE_UP)) {journal::seekBy(sim::JOURNAL_SEEK_STEP);}
+		if (pressedThisFrame(GLFW_KEY_PAGE_DOWN)) {journal::seekBy(-sim::JOURNAL_SEEK_STEP);}
+	}
 
 	//Mouse controls;
 	cursorDelta = cursorPosition - cursorPositionPrevious;
@@ -62,8 +117,75 @@ void handleInputs() {
 
 
 
-int main() {
+int main(int argc, char** argv) {
 	try { //Catch exceptions
+	profiler::nameThread("Main");
+
+	//Command line;
+	//  --headless [benchmark script]   No window, benchmark (or record) offscreen.
+	//  --record <frames>               Record a time-lapse of this many frames, [R] toggles recording in a window.
+	//  --step <sim seconds>            Sim time between time-lapse frames.
+	//  --start <UTC>                   Sim time of the first time-lapse frame, defaults to now.
+	//  --format <y4m|rgb>              Time-lapse file format.
+	//  --hz <rate>                     Frame rate limit without VSync, 0 for unlimited.
+	//  --trace <first> [count]         Write a Chrome trace of these frames to "saved.traces/", [F4] traces the last few.
+	//  --telemetry <endpoint>          Apply live ship positions from udp:<port> or unix:<path>. Repeatable.
+	//  --telemetry-generate <endpoint> [rate] [seconds]
+	//                                  No window, send generated ship positions to a listening app instead.
+	//  --serve <endpoint>              Send every simulation tick to remote consoles, on tcp:[host:]<port> or unix:<path>. Localhost unless a host is given.
+	//  --connect <endpoint>            Show the state sent by a serving app, rather than evaluating it here.
+	//  --journal                       Record every simulation tick to "saved.journals/".
+	//  --replay <file> [UTC]           Play back a journal, from UTC or its start. [Page Up]/[Page Down] seek.
+	//  --views <name,name,...|all>     Show several camera views at once, in a grid. The first still follows [E]/[Q].
+	//  --heatmap <body>                Accumulate ship traffic around this body, shown under the ships. [H] toggles it, [F6] exports it to "saved.heatmaps/".
+	bool headlessMode = false;
+	std::string benchmarkScript = "benchmark.xml";
+	time_t recordStep = sim::RECORDER_TIME_STEP, recordStart = 0;
+	recorder::RecordingFormat recordFormat = recorder::RF_Y4M;
+	std::vector<std::string> telemetryEndpoints;
+	std::string generatorEndpoint, serveEndpoint, connectEndpoint, replayPath, heatmapBody;
+	bool journalMode = false;
+	std::vector<std::string> viewNames;
+	time_t replayStart = 0;
+	double generatorRate = 1.0e6d, generatorSeconds = 10.0d;
+	for (int argIndex=1; argIndex<argc; argIndex++) {
+		std::string arg = argv[argIndex];
+		bool hasValue = (argIndex + 1 < argc) && (argv[argIndex + 1][0] != '-');
+		if (arg == "--headless") {
+			headlessMode = true;
+			if (hasValue) {benchmarkScript = argv[++argIndex];}
+		}
+		else if ((arg == "--record") && hasValue) {recordFrames = static_cast<unsigned int>(std::stoul(argv[++argIndex]));}
+		else if ((arg == "--step") && hasValue) {recordStep = static_cast<time_t>(std::stoll(argv[++argIndex]));}
+		else if ((arg == "--start") && hasValue) {recordStart = static_cast<time_t>(std::stoll(argv[++argIndex]));}
+		else if ((arg == "--format") && hasValue) {recordFormat = (utils::strToLower(argv[++argIndex]) == "rgb") ? recorder::RF_RGB : recorder::RF_Y4M;}
+		else if ((arg == "--hz") && hasValue) {pacer::setRate(std::stod(argv[++argIndex]));}
+		else if ((arg == "--trace") && hasValue) {
+			unsigned long long firstFrame = std::stoull(argv[++argIndex]);
+			unsigned int frameCount = dev::PROFILER_TRACE_FRAMES;
+			if ((argIndex + 1 < argc) && (argv[argIndex + 1][0] != '-')) {frameCount = static_cast<unsigned int>(std::stoul(argv[++argIndex]));}
+			profiler::traceFrames(firstFrame, frameCount);
+		}
+		else if ((arg == "--telemetry") && hasValue) {telemetryEndpoints.push_back(argv[++argIndex]);}
+		else if ((arg == "--serve") && hasValue) {serveEndpoint = argv[++argIndex];}
+		else if ((arg == "--connect") && hasValue) {connectEndpoint = argv[++argIndex];}
+		else if (arg == "--journal") {journalMode = true;}
+		else if ((arg == "--heatmap") && hasValue) {heatmapBody = argv[++argIndex];}
+		else if ((arg == "--views") && hasValue) {
+			std::stringstream names(argv[++argIndex]);
+			for (std::string name; std::getline(names, name, ',');) {if (!name.empty()) {viewNames.push_back(name);}}
+		}
+		else if ((arg == "--replay") && hasValue) {
+			replayPath = argv[++argIndex];
+			if ((argIndex + 1 < argc) && (argv[argIndex + 1][0] != '-')) {replayStart = static_cast<time_t>(std::stoll(argv[++argIndex]));}
+		}
+		else if ((arg == "--telemetry-generate") && hasValue) {
+			generatorEndpoint = argv[++argIndex];
+			if ((argIndex + 1 < argc) && (argv[argIndex + 1][0] != '-')) {generatorRate = std::stod(argv[++argIndex]);}
+			if ((argIndex + 1 < argc) && (argv[argIndex + 1][0] != '-')) {generatorSeconds = std::stod(argv[++argIndex]);}
+		}
+		else {std::cout << "Unknown argument: " << arg << std::endl;}
+	}
 
 #ifdef __WIN32
 	SetConsoleOutputCP(65001); //CP_UTF8, Windows.
@@ -71,17 +193,32 @@ int main() {
 	#pragma execution_character_set("utf-8") //Linux.
 #endif
 
+	std::string xmlFilePath = "data.xml";
+	if (!generatorEndpoint.empty()) {
+		//Stand-in for the real feed, for the ships in the data file.
+		loader::loadXMLdata(xmlFilePath);
+		telemetry::generate(generatorEndpoint, generatorRate, generatorSeconds, static_cast<uint32_t>(data::spacecraft.size()));
+		return 0;
+	}
+
 	currentWindowResolution = display::WINDOW_RESOLUTION;
 	currentRenderResolution = glm::ivec2(
 		glm::min(display::WINDOW_RESOLUTION.x, display::RENDER_RESOLUTION.x),
 		glm::min(display::WINDOW_RESOLUTION.y, display::RENDER_RESOLUTION.y)
 	);
 
-	Window = graphics::initialiseWindow(display::WINDOW_RESOLUTION, "Starbound-Radar/main");
-	glfwSetFramebufferSizeCallback(Window, framebufferSizeCallback);
-	glfwGetCursorPos(Window, &cursorPosition.x, &cursorPosition.y);
+	if (headlessMode) {
+		//No window, renders offscreen into an FBO.
+		currentWindowResolution = display::RENDER_RESOLUTION;
+		headless::initialiseContext();
+	} else {
+		Window = graphics::initialiseWindow(display::WINDOW_RESOLUTION, "Starbound-Radar/main");
+		glfwSetFramebufferSizeCallback(Window, framebufferSizeCallback);
+		redraw::attach(Window);
+		glfwGetCursorPos(Window, &cursorPosition.x, &cursorPosition.y);
+		glfwSwapInterval((dev::VSYNC) ? 1 : 0);
+	}
 	glEnable(GL_BLEND);
-	glfwSwapInterval((dev::VSYNC) ? 1 : 0);
 
 
 
@@ -90,37 +227,106 @@ int main() {
 	utils::GLErrorcheck("Window Creation", true);
 
 	graphics::prepareOpenGL();
-	std::string xmlFilePath = "data.xml";
 	std::cout << "Start UTC time: " << utils::getTimestamp(false) << std::endl;
 	loader::loadXMLdata(xmlFilePath);
+	ephemeris::initialise();
+	trails::initialise();
+	text::initialise();
+	viewports::initialise();
+	viewports::set(viewNames);
+	clusters::initialise();
+
+
+	if (recordStart == 0) {recordStart = utils::getTimestamp();}
+	if (headlessMode) {
+		textures::finish(); //Nothing on screen to show placeholders on.
+		if (recordFrames > 0u) {
+			headless::runRecording(recordFrames, recordStart, recordStep, recordFormat);
+		} else {
+			std::vector<structs::BenchmarkStep> steps = loader::loadBenchmarkScript(benchmarkScript);
+			headless::runBenchmark(steps);
+		}
+		capture::finish();
+		releaseGraphics();
+		headless::destroyContext();
+		return 0;
+	}
+	if (recordFrames > 0u) {recorder::start(currentWindowResolution, recordStart, recordStep, recordFormat);}
+	for (const std::string& endpoint : telemetryEndpoints) {telemetry::listen(endpoint);}
+	if (!serveEndpoint.empty()) {broadcast::serve(serveEndpoint);}
+	if (!connectEndpoint.empty()) {broadcast::connect(connectEndpoint);}
+	if (!replayPath.empty()) {journal::startReplay(replayPath, replayStart);}
+	else if (journalMode) {journal::startRecording(data::spacecraft.size(), data::bodies.size());}
+	if (!heatmapBody.empty()) {heatmap::start(heatmapBody);}
+	simulation::start();
 
 
 
 	frameNumber = 0u;
 	while (!glfwWindowShouldClose(Window)) {
-		double frameStart = glfwGetTime();
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); //Clear screen.
 		handleInputs();
 		if (keyMap[GLFW_KEY_ESCAPE]) {break; /* Quit Immediately, ESC pressed. */}
+		if (recorder::recording() || continuousCapture) {redraw::mark(redraw::RR_CAPTURE);}
+		if (textures::pending() > 0u) {redraw::mark(redraw::RR_TEXTURES);}
+		if (!redraw::due()) {
+			capture::poll(); //Readbacks still in flight.
+			continue; /* Nothing visible changed; Back to waiting. */
+		}
+		redraw::take();
+		double frameStart = glfwGetTime();
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); //Clear screen.
 
 
-		//Calculate current state of the system;
-		bodies::evaluate();
-		spacecraft::evaluate();
+		//Current state of the system; From the simulation thread, or fixed steps while recording a time-lapse.
+		double updateStart = glfwGetTime();
+		time_t UTC;
+		if (recorder::recording()) {
+			UTC = recorder::frameTime();
+			ephemeris::evaluate(UTC); //Bodies, on the GPU or CPU.
+			spacecraft::evaluate(UTC);
+		} else {
+			PROFILE_SCOPE("Apply snapshot");
+			UTC = simulation::apply(); //Newest snapshot, never waits.
+			ephemeris::upload(UTC);
+		}
+		trails::record(UTC); //Newest sample only, when due.
+		viewports::prepare(); //Every view culled from this one state.
+		clusters::update(); //Ships binned per view, only those that changed cell.
+		heatmap::update(); //Newest traffic grids, about once a second.
+		schedule::update(); //Newest arrivals & departures, when ships reached a body.
+		double drawStart = glfwGetTime();
+		framestats::add(framestats::FS_UPDATE, (drawStart - updateStart) * 1.0e3d);
 
 		//Draw the system in its current state;
-		frame::bodies();
-		frame::spacecraft();
+		{PROFILE_GPU_SCOPE("frame::bodies"); frame::bodies();}
+		{PROFILE_GPU_SCOPE("frame::heatmap"); frame::heatmap();}
+		{PROFILE_GPU_SCOPE("frame::spacecraft"); frame::spacecraft();}
+		{PROFILE_GPU_SCOPE("frame::labels"); frame::labels();}
+		framestats::add(framestats::FS_DRAW, (glfwGetTime() - drawStart) * 1.0e3d);
+
+		//Captures are read back asynchronously, from the back buffer before it is swapped.
+		if (pressedThisFrame(GLFW_KEY_F2) || continuousCapture) {capture::saveFramebufferPNG(0u, currentWindowResolution, continuousCapture);}
+		if (recorder::recording()) {
+			recorder::captureFrame(0u, currentWindowResolution);
+			if ((recordFrames > 0u) && (--recordFrames == 0u)) {recorder::stop(); /* --record frame count reached. */}
+		}
 
 
 
-		glfwSwapBuffers(Window);
+		double swapStart = glfwGetTime();
+		{PROFILE_SCOPE("glfwSwapBuffers"); glfwSwapBuffers(Window);}
+		framestats::add(framestats::FS_SWAP, (glfwGetTime() - swapStart) * 1.0e3d);
+		capture::poll();
+		textures::update(); //Decoded textures, within the frame's upload budget.
 
 		float dt = glfwGetTime() - frameStart;
-		if (dev::SHOW_DT_CONSOLE) {std::cout << "Frame #" << frameNumber << " took " << std::setprecision(2) << (dt * 1e3f) << "ms / Hypothetical framerate: " << static_cast<int>(1.0f / dt) << endl;}
-		if (!dev::VSYNC) {while ((glfwGetTime() - frameStart) < display::DT) {std::this_thread::yield();} /* Wait. */}
-		frameRate = ceil(1.0f / (glfwGetTime() - frameStart));
-		if (dev::SHOW_HZ_CONSOLE) {std::cout << "Framerate: " << frameRate << "Hz" << std::endl;}
+		profiler::endFrame(dt * 1.0e3d); //Collects GPU times, writes any trace that is due.
+		framestats::add(framestats::FS_FRAME, dt * 1.0e3d);
+		if (!dev::VSYNC) {pacer::wait(); /* Sleeps, rather than spinning the whole frame. */}
+		double interval = glfwGetTime() - frameStart;
+		frameRate = ceil(1.0f / interval);
+		framestats::add(framestats::FS_INTERVAL, interval * 1.0e3d);
+		framestats::endFrame(); //Summaries every dev::FRAME_STATS_INTERVAL, no console output per frame.
 
 		cursorPositionPrevious = cursorPosition;
 		frameNumber++;
@@ -128,6 +334,16 @@ int main() {
 
 
 	//Cleanup and exit.
+	simulation::stop();
+	heatmap::stop();
+	telemetry::stop();
+	broadcast::stop();
+	journal::stopRecording();
+	journal::stopReplay();
+	recorder::stop();
+	capture::finish(); //Write any captures still in flight.
+	framestats::finish();
+	releaseGraphics();
 	glfwDestroyWindow(Window);
 	glfwTerminate();
 	return 0;
@@ -0,0 +1,462 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "threading.h"
+#include "profiler.h"
+#include "sockets.h"
+#include "broadcast.h"
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Simulation thread -> TripleBuffer<State> -> server thread -> per-client queues -> sockets
+ - The server keeps one reference state; what every up-to-date client last received.
+   Each tick, only entities more than sim::BROADCAST_THRESHOLD from their reference are
+   sent, quantized to sim::BROADCAST_QUANTUM, and the reference moves by exactly what
+   was sent. Clients apply the same steps, so they never drift, and an idle system
+   costs a header per tick whatever the fleet size.
+ - Every frame is encoded once and shared between the client queues.
+ - A client more than sim::BROADCAST_CLIENT_QUEUE frames behind has its queued frames
+   dropped (a frame already part sent is finished, so the stream stays in step), then
+   gets a keyframe of the current reference and carries on from there.
+ - New clients start with a keyframe too. Sockets are non-blocking; One poll() loop.
+Linux only.
+\* -------------------------------------------------------------------------------- */
+
+
+struct State {
+	time_t UTC = 0;
+	unsigned long long tick = 0u;
+	uint32_t bodyCount = 0u;
+	std::vector<glm::ivec2> positions; //Bodies, then ships.
+};
+
+typedef std::shared_ptr<const std::vector<unsigned char>> Frame;
+
+struct Client {
+	int socket = -1;
+	std::deque<Frame> queue;
+	size_t offset = 0u; //Sent of the front frame.
+	bool needsKeyframe = true;
+};
+
+
+//Server;
+static sockets::Endpoint serverEndpoint;
+static int serverSocket = -1, wakeEvent = -1;
+static std::thread serverThread;
+static threading::TripleBuffer<State> published;
+static std::vector<glm::ivec2> reference; //Server thread only.
+static uint32_t referenceBodies = 0u;
+static std::atomic<size_t> clientCount = 0u;
+static std::atomic<uint64_t> framesQueued = 0u, keyframesQueued = 0u, framesDropped = 0u, bytesSent = 0u;
+
+//Client;
+static int clientSocket = -1;
+static std::thread clientThread;
+static threading::TripleBuffer<State> received;
+static std::atomic<bool> haveState = false;
+
+static std::atomic<bool> stopping = false;
+
+
+
+//// ENCODING ////
+template<typename T>
+static inline void put(std::vector<unsigned char>& buffer, T value) {
+	size_t at = buffer.size();
+	buffer.resize(at + sizeof(T));
+	std::memcpy(buffer.data() + at, &value, sizeof(T));
+}
+
+template<typename T>
+static inline T get(const unsigned char* data) {
+	T value;
+	std::memcpy(&value, data, sizeof(T));
+	return value;
+}
+
+static void putHeader(std::vector<unsigned char>& buffer, broadcast::FrameType type, const State& state) {
+	buffer.insert(buffer.end(), {'S', 'B', 'B', 'C', static_cast<unsigned char>(type), 0u, 0u, 0u});
+	put<uint32_t>(buffer, 0u); //Payload size, filled in once known.
+	put<uint64_t>(buffer, state.tick);
+	put<int64_t>(buffer, static_cast<int64_t>(state.UTC));
+}
+
+static Frame finishFrame(std::vector<unsigned char>& buffer) {
+	uint32_t payload = static_cast<uint32_t>(buffer.size() - broadcast::HEADER_SIZE);
+	std::memcpy(buffer.data() + 8u, &payload, sizeof(payload));
+	return std::make_shared<const std::vector<unsigned char>>(std::move(buffer));
+}
+
+
+static Frame encodeKeyframe(const State& state) {
+	std::vector<unsigned char> buffer;
+	buffer.reserve(broadcast::HEADER_SIZE + 8u + (reference.size() * 8u));
+	putHeader(buffer, broadcast::FT_KEYFRAME, state);
+	put<uint32_t>(buffer, referenceBodies);
+	put<uint32_t>(buffer, static_cast<uint32_t>(reference.size() - referenceBodies));
+	for (const glm::ivec2& position : reference) {
+		put<int32_t>(buffer, position.x);
+		put<int32_t>(buffer, position.y);
+	}
+	return finishFrame(buffer);
+}
+
+
+static Frame encodeDelta(const State& state) {
+	//Moves the reference by exactly what is sent.
+	std::vector<unsigned char> relative, absolute;
+	uint32_t relativeCount = 0u, absoluteCount = 0u;
+	for (uint32_t entity=0u; entity<reference.size(); entity++) {
+		glm::ivec2 difference = state.positions[entity] - reference[entity];
+		if (std::max(std::abs(difference.x), std::abs(difference.y)) <= sim::BROADCAST_THRESHOLD) {continue; /* Close enough. */}
+
+		glm::ivec2 steps = glm::ivec2(
+			static_cast<int>(std::lround(static_cast<double>(difference.x) / sim::BROADCAST_QUANTUM)),
+			static_cast<int>(std::lround(static_cast<double>(difference.y) / sim::BROADCAST_QUANTUM))
+		);
+		bool fits = (entity <= std::numeric_limits<uint16_t>::max()) &&
+					(std::max(std::abs(steps.x), std::abs(steps.y)) <= std::numeric_limits<int16_t>::max());
+		if (fits) {
+			put<uint16_t>(relative, static_cast<uint16_t>(entity));
+			put<int16_t>(relative, static_cast<int16_t>(steps.x));
+			put<int16_t>(relative, static_cast<int16_t>(steps.y));
+			reference[entity] += steps * sim::BROADCAST_QUANTUM;
+			relativeCount++;
+		} else {
+			put<uint32_t>(absolute, entity);
+			put<int32_t>(absolute, state.positions[entity].x);
+			put<int32_t>(absolute, state.positions[entity].y);
+			reference[entity] = state.positions[entity];
+			absoluteCount++;
+		}
+	}
+
+	std::vector<unsigned char> buffer;
+	buffer.reserve(broadcast::HEADER_SIZE + 8u + relative.size() + absolute.size());
+	putHeader(buffer, broadcast::FT_DELTA, state);
+	put<uint32_t>(buffer, relativeCount);
+	put<uint32_t>(buffer, absoluteCount);
+	buffer.insert(buffer.end(), relative.begin(), relative.end());
+	buffer.insert(buffer.end(), absolute.begin(), absolute.end());
+	return finishFrame(buffer);
+}
+//// ENCODING ////
+
+
+
+//// SERVER ////
+#ifdef __linux__
+static void dropQueued(Client& client) {
+	//Keeps a part sent frame, the stream would be out of step without the rest of it.
+	size_t keep = ((client.offset > 0u) && !client.queue.empty()) ? 1u : 0u;
+	framesDropped += client.queue.size() - keep;
+	client.queue.resize(keep);
+}
+
+
+static void queueState(const State& state, std::vector<Client>& clients) {
+	Frame delta, keyframe;
+	if ((reference.size() != state.positions.size()) || (referenceBodies != state.bodyCount)) {
+		//First state, or the data changed; Everyone starts again from a keyframe.
+		reference = state.positions;
+		referenceBodies = state.bodyCount;
+		for (Client& client : clients) {client.needsKeyframe = true;}
+	} else {
+		delta = encodeDelta(state);
+	}
+
+	for (Client& client : clients) {
+		if (client.queue.size() >= sim::BROADCAST_CLIENT_QUEUE) {
+			dropQueued(client); //Too slow; Skip what it has not had yet.
+			client.needsKeyframe = true;
+		}
+		if (client.needsKeyframe) {
+			if (!keyframe) {keyframe = encodeKeyframe(state);}
+			dropQueued(client); //Anything still queued is older than the keyframe.
+			client.queue.push_back(keyframe);
+			client.needsKeyframe = false;
+			keyframesQueued++;
+		} else {
+			client.queue.push_back(delta);
+		}
+		framesQueued++;
+	}
+}
+
+
+static bool flush(Client& client) {
+	//False if the client has gone.
+	while (!client.queue.empty()) {
+		const std::vector<unsigned char>& frame = *client.queue.front();
+		ssize_t sent = ::send(client.socket, frame.data() + client.offset, frame.size() - client.offset, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (sent < 0) {return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);}
+		bytesSent += static_cast<uint64_t>(sent);
+		client.offset += static_cast<size_t>(sent);
+		if (client.offset < frame.size()) {return true; /* Socket buffer full, carry on once writable. */}
+		client.queue.pop_front();
+		client.offset = 0u;
+	}
+	return true;
+}
+
+
+static void serveClients() {
+	//Server thread.
+	profiler::nameThread("Broadcast");
+	std::vector<Client> clients;
+	std::vector<pollfd> polls;
+	while (!stopping) {
+		polls.clear();
+		polls.push_back({serverSocket, POLLIN, 0});
+		polls.push_back({wakeEvent, POLLIN, 0});
+		for (Client& client : clients) {
+			polls.push_back({client.socket, static_cast<short>(POLLIN | ((client.queue.empty()) ? 0 : POLLOUT)), 0});
+		}
+		if (::poll(polls.data(), polls.size(), 100) < 0) {continue; /* Interrupted. */}
+
+		if (polls[0].revents & POLLIN) {
+			int socket = ::accept4(serverSocket, nullptr, nullptr, SOCK_NONBLOCK);
+			if (socket >= 0) {
+				int noDelay = 1;
+				::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay)); //Fails harmlessly on a Unix socket.
+				clients.push_back({socket});
+			}
+		}
+		if (polls[1].revents & POLLIN) {
+			uint64_t count;
+			if (::read(wakeEvent, &count, sizeof(count)) < 0) {count = 0u;}
+			if (published.acquire()) {queueState(published.front(), clients);}
+		}
+
+		//Clients never send anything; Readable means closed (or misbehaving).
+		std::vector<Client> remaining;
+		remaining.reserve(clients.size());
+		for (size_t index=0; index<clients.size(); index++) {
+			Client& client = clients[index];
+			short events = (index + 2u < polls.size()) ? polls[index + 2u].revents : 0; //Accepted this pass if not.
+			bool gone = (events & (POLLERR | POLLHUP | POLLNVAL));
+			if (events & POLLIN) {
+				unsigned char discard[256];
+				gone = gone || (::recv(client.socket, discard, sizeof(discard), MSG_DONTWAIT) <= 0);
+			}
+			if (!gone) {gone = !flush(client);}
+			if (gone) {::close(client.socket); continue;}
+			remaining.push_back(std::move(client));
+		}
+		clients = std::move(remaining);
+		clientCount = clients.size();
+	}
+	for (Client& client : clients) {::close(client.socket);}
+	clientCount = 0u;
+}
+#endif
+//// SERVER ////
+
+
+
+//// CLIENT ////
+#ifdef __linux__
+static bool readFully(unsigned char* data, size_t size) {
+	while (size > 0u) {
+		ssize_t got = ::recv(clientSocket, data, size, 0);
+		if (got < 0 && ((errno == EAGAIN) || (errno == EINTR))) {
+			if (stopping) {return false;}
+			continue; //Receive timeout, so stopping is noticed.
+		}
+		if (got <= 0) {return false;}
+		data += got;
+		size -= static_cast<size_t>(got);
+	}
+	return true;
+}
+
+
+static void receiveStates() {
+	//Client thread.
+	profiler::nameThread("Broadcast client");
+	std::vector<glm::ivec2> state;
+	uint32_t bodyCount = 0u;
+	bool synced = false;
+	std::array<unsigned char, broadcast::HEADER_SIZE> header;
+	std::vector<unsigned char> payload;
+
+	while (!stopping && readFully(header.data(), header.size())) {
+		if (std::memcmp(header.data(), "SBBC", 4u) != 0) {std::cerr << "Broadcast stream is corrupt, disconnecting." << std::endl; break;}
+		uint32_t payloadSize = get<uint32_t>(header.data() + 8u);
+		if (payloadSize > sim::BROADCAST_MAX_FRAME) {std::cerr << "Broadcast frame of " << payloadSize << " bytes is too large, disconnecting." << std::endl; break;}
+		payload.resize(payloadSize);
+		if (!readFully(payload.data(), payload.size())) {break;}
+		const unsigned char* data = payload.data();
+		const unsigned char* end = data + payload.size();
+		if (payload.size() < 8u) {continue;}
+
+		if (header[4] == broadcast::FT_KEYFRAME) {
+			bodyCount = get<uint32_t>(data);
+			size_t count = static_cast<size_t>(bodyCount) + get<uint32_t>(data + 4u);
+			if (payload.size() < 8u + (count * 8u)) {continue;}
+			state.resize(count);
+			for (size_t entity=0; entity<count; entity++) {
+				state[entity] = glm::ivec2(get<int32_t>(data + 8u + (entity * 8u)), get<int32_t>(data + 12u + (entity * 8u)));
+			}
+			synced = true;
+		} else if ((header[4] == broadcast::FT_DELTA) && synced) {
+			uint32_t relativeCount = get<uint32_t>(data), absoluteCount = get<uint32_t>(data + 4u);
+			data += 8u;
+			size_t available = static_cast<size_t>(end - data);
+			if (
+				(relativeCount > available / 6u) || (absoluteCount > available / 12u) ||
+				((static_cast<uint64_t>(relativeCount) * 6u) + (static_cast<uint64_t>(absoluteCount) * 12u) > available)
+			) {continue; /* Counts the payload cannot hold. */}
+			for (uint32_t index=0u; index<relativeCount; index++, data+=6u) {
+				uint16_t entity = get<uint16_t>(data);
+				if (entity < state.size()) {state[entity] += glm::ivec2(get<int16_t>(data + 2u), get<int16_t>(data + 4u)) * sim::BROADCAST_QUANTUM;}
+			}
+			for (uint32_t index=0u; index<absoluteCount; index++, data+=12u) {
+				uint32_t entity = get<uint32_t>(data);
+				if (entity < state.size()) {state[entity] = glm::ivec2(get<int32_t>(data + 4u), get<int32_t>(data + 8u));}
+			}
+		} else {
+			continue; //Unknown, or a delta before the first keyframe.
+		}
+
+		State& back = received.back();
+		back.tick = get<uint64_t>(header.data() + 12u);
+		back.UTC = static_cast<time_t>(get<int64_t>(header.data() + 20u));
+		back.bodyCount = bodyCount;
+		back.positions = state;
+		received.publish();
+		haveState = true;
+	}
+	if (!stopping) {std::cout << "Disconnected from the broadcast server, evaluating locally." << std::endl;}
+	haveState = false;
+}
+#endif
+//// CLIENT ////
+
+
+
+
+namespace broadcast {
+
+bool serve(const std::string& endpointText) {
+#ifdef __linux__
+	if (serverSocket >= 0) {return false; /* Already serving. */}
+	if (!sockets::parse(endpointText, serverEndpoint)) {
+		std::cerr << "Invalid broadcast endpoint [" << endpointText << "] : Expected tcp:[host:]<port>, unix:<path> or a port." << std::endl;
+		return false;
+	}
+	serverSocket = sockets::listen(serverEndpoint, SOCK_STREAM, true); //Unauthenticated; Other machines only with an explicit host, e.g. tcp:0.0.0.0:<port>.
+	if (serverSocket < 0) {return false;}
+	::fcntl(serverSocket, F_SETFL, ::fcntl(serverSocket, F_GETFL) | O_NONBLOCK);
+	wakeEvent = ::eventfd(0u, EFD_NONBLOCK);
+
+	stopping = false;
+	serverThread = std::thread(serveClients);
+	std::cout << "Broadcasting state on [" << endpointText << "]" << std::endl;
+	return true;
+#else
+	std::cerr << "Broadcasting is only supported on Linux." << std::endl;
+	return false;
+#endif
+}
+
+
+void publish(const simulation::Snapshot& snapshot) {
+#ifdef __linux__
+	if (serverSocket < 0) {return;}
+	if ((snapshot.bodyPositions.size() > sim::BROADCAST_MAX_BODIES) || (snapshot.shipPositions.size() > sim::BROADCAST_MAX_SHIPS)) {
+		static bool warned = false;
+		if (!warned) {std::cerr << "Too many bodies or ships to broadcast, clients will not be sent this data." << std::endl; warned = true;}
+		return;
+	}
+	State& state = published.back();
+	state.UTC = snapshot.UTC;
+	state.tick = snapshot.tick;
+	state.bodyCount = static_cast<uint32_t>(snapshot.bodyPositions.size());
+	state.positions.resize(snapshot.bodyPositions.size() + snapshot.shipPositions.size());
+	std::copy(snapshot.bodyPositions.begin(), snapshot.bodyPositions.end(), state.positions.begin());
+	std::copy(snapshot.shipPositions.begin(), snapshot.shipPositions.end(), state.positions.begin() + snapshot.bodyPositions.size());
+	published.publish();
+
+	uint64_t one = 1u;
+	if (::write(wakeEvent, &one, sizeof(one)) < 0) {return; /* Already signalled. */}
+#endif
+}
+
+
+Stats stats() {
+	return {clientCount.load(), framesQueued.load(), keyframesQueued.load(), framesDropped.load(), bytesSent.load()};
+}
+
+
+
+bool connect(const std::string& endpointText) {
+#ifdef __linux__
+	sockets::Endpoint endpoint;
+	if (!sockets::parse(endpointText, endpoint)) {
+		std::cerr << "Invalid broadcast endpoint [" << endpointText << "]" << std::endl;
+		return false;
+	}
+	clientSocket = sockets::connect(endpoint, SOCK_STREAM);
+	if (clientSocket < 0) {return false;}
+	timeval timeout = {0, 100000}; //100ms
+	::setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	stopping = false;
+	clientThread = std::thread(receiveStates);
+	std::cout << "Receiving state from [" << endpointText << "]" << std::endl;
+	return true;
+#else
+	std::cerr << "Broadcasting is only supported on Linux." << std::endl;
+	return false;
+#endif
+}
+
+
+bool connected() {
+	return haveState;
+}
+
+
+void apply(std::vector<structs::CelestialBody>& bodies, std::vector<structs::SpaceCraft>& ships) {
+	if (!haveState) {return;}
+	received.acquire(); //Otherwise the last state again, positions were just re-evaluated.
+	const State& state = received.front();
+	if ((state.bodyCount != bodies.size()) || (state.positions.size() != bodies.size() + ships.size())) {return; /* Server has other data. */}
+	for (size_t index=0; index<bodies.size(); index++) {bodies[index].position = state.positions[index];}
+	for (size_t index=0; index<ships.size(); index++) {ships[index].position = state.positions[bodies.size() + index];}
+}
+
+
+
+void stop() {
+	stopping = true;
+	if (serverThread.joinable()) {
+		serverThread.join();
+		sockets::close(serverSocket, serverEndpoint);
+		sockets::close(wakeEvent);
+		serverSocket = wakeEvent = -1;
+		Stats s = stats();
+		std::cout << "Broadcast stopped : " << s.frames << " frames (" << s.keyframes << " keyframes) queued, " << s.dropped << " dropped, " << s.bytes << " bytes sent." << std::endl;
+	}
+	if (clientThread.joinable()) {
+		clientThread.join();
+		sockets::close(clientSocket);
+		clientSocket = -1;
+	}
+}
+
+}
@@ -0,0 +1,51 @@
+#ifndef BROADCAST_H
+#define BROADCAST_H
+
+#include "includes.h"
+#include "constants.h"
+#include "global.h"
+#include "simulation.h"
+
+
+
+
+namespace broadcast {
+
+	//Wire format, little endian. A stream of frames, each a header then its payload;
+	//  Header   : "SBBC", uint8 type, uint8 0, uint16 0, uint32 payload bytes, uint64 tick, int64 UTC.
+	//  Keyframe : uint32 body count, uint32 ship count, then int32 x, y of every body, then of every ship.
+	//  Delta    : uint32 relative count, uint32 absolute count, then
+	//             relative entries; uint16 entity, int16 dx, dy (in steps of sim::BROADCAST_QUANTUM), then
+	//             absolute entries; uint32 entity, int32 x, y.
+	//  Entities are every body, then every ship, in data file order. Deltas apply to the last state received.
+	enum FrameType : uint8_t {
+		FT_KEYFRAME = 1u,
+		FT_DELTA = 2u
+	};
+	constexpr size_t HEADER_SIZE = 28u;
+
+	struct Stats {
+		size_t clients = 0u;
+		uint64_t frames = 0u;    //Queued, over every client.
+		uint64_t keyframes = 0u; //Of those; New clients, and slow ones after a drop.
+		uint64_t dropped = 0u;   //Stale frames thrown away for slow clients.
+		uint64_t bytes = 0u;     //Sent, over every client.
+	};
+
+
+	//Server; Sends each simulation tick to every connected client, on its own thread. "tcp:[host:]<port>" or "unix:<path>".
+	bool serve(const std::string& endpoint);
+	void publish(const simulation::Snapshot& snapshot); //Simulation thread, every tick. Never waits on a client.
+	Stats stats();
+
+	//Client; Receives on its own thread, instead of evaluating positions locally.
+	bool connect(const std::string& endpoint);
+	bool connected();
+	void apply(std::vector<structs::CelestialBody>& bodies, std::vector<structs::SpaceCraft>& ships); //Simulation thread, the newest state received.
+
+	void stop(); //Server & client.
+
+}
+
+
+#endif
@@ -0,0 +1,212 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "threading.h"
+#include "capture.h"
+#include <stb_image_write.h>
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Captures never stall the render thread;
+ - Pixels are copied into a ring of PBOs, with a fence per copy.
+ - poll() maps only the copies whose fence has already signalled, and hands them on.
+ - PNG encoding (the slow part) runs on the worker pool.
+When the ring or the encoder queue is full, captures are dropped instead of waiting.
+\* -------------------------------------------------------------------------------- */
+
+
+struct Readback {
+	GLuint PBO = 0u;
+	size_t capacity = 0u;	//Bytes allocated for the PBO.
+	GLsync fence = nullptr;
+	glm::ivec2 resolution = glm::ivec2(0, 0);
+	capture::ReadbackCallback callback;
+};
+
+static std::array<Readback, display::CAPTURE_PBO_COUNT> ring;
+static size_t ringHead = 0u, ringInFlight = 0u; //Oldest readback, and how many follow it.
+
+static std::atomic<size_t> dropped = 0u;
+static unsigned int captureSequence = 0u;
+
+
+
+static Readback* nextSlot(glm::ivec2 resolution) {
+	if (ringInFlight == ring.size()) {return nullptr;}
+	Readback& slot = ring[(ringHead + ringInFlight) % ring.size()];
+
+	size_t size = static_cast<size_t>(resolution.x) * static_cast<size_t>(resolution.y) * 4u;
+	if (!slot.PBO) {glGenBuffers(1, &slot.PBO);}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.PBO);
+	if (slot.capacity < size) {
+		//Only reallocated when the resolution grows.
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		slot.capacity = size;
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	return &slot;
+}
+
+static void submitSlot(Readback* slot, glm::ivec2 resolution, capture::ReadbackCallback& callback) {
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot->resolution = resolution;
+	slot->callback = std::move(callback);
+	ringInFlight++;
+}
+
+
+static bool completeOldest(bool wait) {
+	if (ringInFlight == 0u) {return false;}
+	Readback& slot = ring[ringHead];
+
+	GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, (wait) ? 1000000000u : 0u);
+	if ((status == GL_TIMEOUT_EXPIRED) || (status == GL_WAIT_FAILED)) {return false;}
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+
+	size_t size = static_cast<size_t>(slot.resolution.x) * static_cast<size_t>(slot.resolution.y) * 4u;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.PBO);
+	const unsigned char* pixels = static_cast<const unsigned char*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT));
+	if (pixels) {
+		slot.callback(pixels, slot.resolution);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.callback = nullptr;
+	ringHead = (ringHead + 1u) % ring.size();
+	ringInFlight--;
+	return true;
+}
+
+
+
+static std::filesystem::path uniqueImagePath() {
+	//getTimestampStr() only changes every second, so add milliseconds and a sequence number.
+	static bool createdDirectory = false;
+	std::filesystem::path dirName = std::filesystem::path("saved.images");
+	if (!createdDirectory) {std::filesystem::create_directories(dirName); createdDirectory = true;}
+
+	std::ostringstream name;
+	name << utils::getTimestampStrPrecise() << "_" << std::setw(4) << std::setfill('0') << (captureSequence++ % 10000u) << ".png";
+	return dirName / name.str();
+}
+
+static void writePNG(std::filesystem::path imagePath, std::vector<unsigned char>& rgba, glm::ivec2 resolution, bool silent) {
+	//Worker thread. Drops alpha and flips to top row first, as stbi_flip_vertically_on_write() is global state.
+	size_t width = resolution.x, height = resolution.y;
+	std::vector<unsigned char> rgb(width * height * 3u);
+	for (size_t y=0; y<height; y++) {
+		const unsigned char* source = rgba.data() + (y * width * 4u);
+		unsigned char* destination = rgb.data() + ((height - 1u - y) * width * 3u);
+		for (size_t x=0; x<width; x++) {
+			destination[(x * 3u) + 0u] = source[(x * 4u) + 0u];
+			destination[(x * 3u) + 1u] = source[(x * 4u) + 1u];
+			destination[(x * 3u) + 2u] = source[(x * 4u) + 2u];
+		}
+	}
+
+	stbi_write_png(
+		imagePath.string().c_str(),
+		resolution.x, resolution.y,
+		3u, rgb.data(), resolution.x*3u
+	);
+
+	if (!silent) {std::cout << "Successfully saved image as : [" << imagePath << "]" << std::endl;}
+}
+
+static capture::ReadbackCallback encodeCallback(bool silent) {
+	std::filesystem::path imagePath = uniqueImagePath(); //Named when requested, not when encoded.
+	return [imagePath, silent](const unsigned char* pixels, glm::ivec2 resolution) {
+		std::vector<unsigned char> rgba(pixels, pixels + (static_cast<size_t>(resolution.x) * resolution.y * 4u));
+		threading::workers().submit([imagePath, silent, resolution, rgba = std::move(rgba)]() mutable {
+			writePNG(imagePath, rgba, resolution, silent);
+		});
+	};
+}
+
+static bool canEncode() {
+	//Bound the encoder backlog (and its memory), rather than fall behind forever.
+	if (threading::workers().pending() >= (threading::workers().size() * 2u) + 2u) {return false;}
+	if (capture::ringFull()) {capture::poll();}
+	return !capture::ringFull();
+}
+
+
+
+
+namespace capture {
+
+//// READBACK ////
+bool requestFramebuffer(GLuint FBO, glm::ivec2 resolution, ReadbackCallback callback) {
+	Readback* slot = nextSlot(resolution);
+	if (!slot) {return false;}
+
+	GLint previousFBO;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousFBO);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+	glReadBuffer((FBO == 0u) ? GL_BACK : GL_COLOR_ATTACHMENT0);
+	glReadPixels(0, 0, resolution.x, resolution.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); //Into the PBO, returns immediately.
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, previousFBO);
+
+	submitSlot(slot, resolution, callback);
+	return true;
+}
+
+bool requestTexture(GLuint textureID, glm::ivec2 resolution, ReadbackCallback callback) {
+	Readback* slot = nextSlot(resolution);
+	if (!slot) {return false;}
+
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); //Into the PBO, returns immediately.
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	submitSlot(slot, resolution, callback);
+	return true;
+}
+
+void poll() {
+	while (completeOldest(false)) {}
+}
+
+void flush() {
+	while (completeOldest(true)) {}
+}
+
+void flushOldest() {
+	completeOldest(true);
+}
+
+bool ringFull() {
+	return ringInFlight == ring.size();
+}
+//// READBACK ////
+
+
+
+//// IMAGES ////
+bool saveFramebufferPNG(GLuint FBO, glm::ivec2 resolution, bool silent) {
+	if (!canEncode() || !requestFramebuffer(FBO, resolution, encodeCallback(silent))) {dropped++; return false;}
+	return true;
+}
+
+bool saveTexturePNG(GLuint textureID, glm::ivec2 resolution, bool silent) {
+	if (!canEncode() || !requestTexture(textureID, resolution, encodeCallback(silent))) {dropped++; return false;}
+	return true;
+}
+
+size_t droppedCaptures() {
+	return dropped;
+}
+
+void finish() {
+	flush();
+	threading::workers().wait();
+}
+//// IMAGES ////
+
+}
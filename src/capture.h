@@ -0,0 +1,38 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "includes.h"
+#include "constants.h"
+
+
+
+
+namespace capture {
+
+	//Pixels are RGBA8, bottom row first. Only valid during the call.
+	typedef std::function<void(const unsigned char* pixels, glm::ivec2 resolution)> ReadbackCallback;
+
+
+	//// READBACK ////
+	//Queue an asynchronous copy into the PBO ring. False if the ring is full.
+	bool requestFramebuffer(GLuint FBO, glm::ivec2 resolution, ReadbackCallback callback); //FBO 0 reads the back buffer.
+	bool requestTexture(GLuint textureID, glm::ivec2 resolution, ReadbackCallback callback);
+	void poll();  //Hand every finished readback to its callback, never waits. Call once per frame.
+	void flush(); //Wait for every readback in flight.
+	void flushOldest(); //Wait for only the oldest readback, to free one slot.
+	bool ringFull();
+	//// READBACK ////
+
+
+	//// IMAGES ////
+	//Encoded to PNG on the worker pool, in "saved.images/". False if the capture was dropped.
+	bool saveFramebufferPNG(GLuint FBO, glm::ivec2 resolution, bool silent=false);
+	bool saveTexturePNG(GLuint textureID, glm::ivec2 resolution, bool silent=false);
+	size_t droppedCaptures(); //Captures skipped so far, rather than stall the frame.
+	void finish(); //Flush, then wait for every PNG to be written. Call before exiting.
+	//// IMAGES ////
+
+}
+
+
+#endif
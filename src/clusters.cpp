@@ -0,0 +1,176 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "streaming.h"
+#include "profiler.h"
+#include "viewports.h"
+#include "clusters.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Level of detail for large fleets; Each view bins the ships into a screen space grid
+(display::SHIP_CLUSTER_CELL pixels a side).
+ - A cell holding display::SHIP_CLUSTER_MIN ships or more is drawn as one marker,
+   weighted by its count. Sparser cells draw their ships individually, with trails.
+   Zooming in spreads the ships over more cells, until each is drawn on its own.
+ - Cells keep a linked list of their ships, which persists between frames; Only ships
+   that moved to another cell are unlinked & relinked. A new camera re-bins them all.
+ - Markers are collected per cell, so there are never more than the view has cells;
+   The draws (and labels) cost the same for a thousand ships or a million.
+\* -------------------------------------------------------------------------------- */
+
+
+struct Grid {
+	//What the ships were binned for; Any change re-bins every ship.
+	const structs::CelestialBody* focus = nullptr;
+	float scale = 0.0f;
+	glm::ivec2 offset = glm::ivec2(0, 0), size = glm::ivec2(0, 0);
+
+	glm::ivec2 cells = glm::ivec2(0, 0); //Columns, rows.
+	std::vector<GLuint> counts;	//Ships per cell.
+	std::vector<GLint> heads;	//First ship in each cell, -1 if empty.
+	std::vector<GLint> shipCell, next, previous; //Per ship; Its cell (-1 off the view) & neighbours in that cell's list.
+
+	std::vector<clusters::Marker> markers;
+	clusters::ViewMarkers view = {0, 0, 0};
+};
+
+static std::vector<Grid> grids;
+static streaming::StreamBuffer markerStream; //Per view, regionMarkers apart.
+static size_t regionMarkers = 0u;
+static const clusters::ViewMarkers noMarkers = {0, 0, 0};
+
+
+
+static void unlink(Grid& grid, GLint ship) {
+	GLint cell = grid.shipCell[ship];
+	if (cell < 0) {return;}
+	if (grid.previous[ship] >= 0) {grid.next[grid.previous[ship]] = grid.next[ship];} else {grid.heads[cell] = grid.next[ship];}
+	if (grid.next[ship] >= 0) {grid.previous[grid.next[ship]] = grid.previous[ship];}
+	grid.counts[cell]--;
+	grid.shipCell[ship] = -1;
+}
+
+static void link(Grid& grid, GLint ship, GLint cell) {
+	grid.shipCell[ship] = cell;
+	if (cell < 0) {return;}
+	grid.previous[ship] = -1;
+	grid.next[ship] = grid.heads[cell];
+	if (grid.heads[cell] >= 0) {grid.previous[grid.heads[cell]] = ship;}
+	grid.heads[cell] = ship;
+	grid.counts[cell]++;
+}
+
+
+static void reset(Grid& grid, const structs::CameraView& view, glm::ivec2 size) {
+	grid.focus = view.focusBody;
+	grid.scale = view.scale;
+	grid.offset = view.offset;
+	grid.size = size;
+	grid.cells = (size + display::SHIP_CLUSTER_CELL - 1) / display::SHIP_CLUSTER_CELL;
+	grid.counts.assign(grid.cells.x * grid.cells.y, 0u);
+	grid.heads.assign(grid.cells.x * grid.cells.y, -1);
+	grid.shipCell.assign(data::spacecraft.size(), -1);
+	grid.next.assign(data::spacecraft.size(), -1);
+	grid.previous.assign(data::spacecraft.size(), -1);
+}
+
+
+static void bin(Grid& grid, const structs::CameraView& view) {
+	//Same projection as the shaders & labels.
+	glm::ivec2 focus = view.focusBody->position;
+	glm::ivec2 centre = view.offset + (grid.size / 2);
+	GLint* shipCell = grid.shipCell.data();
+	for (size_t index=0; index<data::spacecraft.size(); index++) {
+		const glm::ivec2& position = data::spacecraft[index].position;
+		int x = static_cast<int>(static_cast<float>(position.x - focus.x) * view.scale) + centre.x;
+		int y = static_cast<int>(static_cast<float>(position.y - focus.y) * view.scale) + centre.y;
+		GLint cell = -1;
+		if ((x >= 0) && (y >= 0) && (x < grid.size.x) && (y < grid.size.y)) {
+			cell = ((y / display::SHIP_CLUSTER_CELL) * grid.cells.x) + (x / display::SHIP_CLUSTER_CELL);
+		}
+		GLint ship = static_cast<GLint>(index);
+		if (cell == shipCell[ship]) {continue; /* Same cell as last frame. */}
+		unlink(grid, ship);
+		link(grid, ship, cell);
+	}
+}
+
+
+static void collect(Grid& grid, const structs::CameraView& view) {
+	//Individual ships first (they also get trails), then the clusters.
+	static std::vector<clusters::Marker> clustered;
+	clustered.clear();
+	grid.markers.clear();
+	glm::ivec2 focus = view.focusBody->position;
+	glm::ivec2 centre = view.offset + (grid.size / 2);
+	for (GLint cell=0; cell<static_cast<GLint>(grid.counts.size()); cell++) {
+		GLuint count = grid.counts[cell];
+		if (count == 0u) {continue;}
+		if (count >= display::SHIP_CLUSTER_MIN) {
+			glm::ivec2 middle = (glm::ivec2(cell % grid.cells.x, cell / grid.cells.x) * display::SHIP_CLUSTER_CELL) + (display::SHIP_CLUSTER_CELL / 2);
+			clustered.push_back({glm::min(middle, grid.size - 1), count, 0u});
+			continue;
+		}
+		for (GLint ship=grid.heads[cell]; ship>=0; ship=grid.next[ship]) {
+			glm::ivec2 pixel = glm::ivec2(glm::vec2(data::spacecraft[ship].position - focus) * view.scale) + centre;
+			grid.markers.push_back({pixel, 1u, static_cast<GLuint>(ship)});
+		}
+	}
+	grid.view.shipCount = static_cast<GLsizei>(grid.markers.size());
+	grid.markers.insert(grid.markers.end(), clustered.begin(), clustered.end());
+	grid.view.markerCount = static_cast<GLsizei>(std::min(grid.markers.size(), regionMarkers));
+	grid.view.shipCount = std::min(grid.view.shipCount, grid.view.markerCount);
+}
+
+
+
+
+namespace clusters {
+
+void initialise() {
+	//Every view is at most the render resolution, so this many cells (each at most SHIP_CLUSTER_MIN-1 markers).
+	glm::ivec2 cells = (display::RENDER_RESOLUTION + display::SHIP_CLUSTER_CELL - 1) / display::SHIP_CLUSTER_CELL;
+	regionMarkers = static_cast<size_t>(cells.x * cells.y) * std::max(display::SHIP_CLUSTER_MIN - 1u, 1u);
+	markerStream.create(GL_SHADER_STORAGE_BUFFER, display::VIEWPORT_MAX * regionMarkers * sizeof(Marker), bindings::SHIP_MARKERS);
+	grids.clear();
+}
+
+void release() {
+	markerStream.destroy();
+}
+
+
+void update() {
+	PROFILE_SCOPE("clusters::update");
+	grids.resize(viewports::count());
+	Marker* mapped = markerStream.map<Marker>();
+	for (size_t index=0; index<grids.size(); index++) {
+		Grid& grid = grids[index];
+		const viewports::Viewport& viewport = viewports::get(index);
+		const structs::CameraView& view = viewports::view(index);
+		if ((grid.focus != view.focusBody) || (grid.scale != view.scale) || (grid.offset != view.offset) || (grid.size != viewport.size) || (grid.shipCell.size() != data::spacecraft.size())) {
+			reset(grid, view, viewport.size);
+		}
+
+		bin(grid, view);
+		collect(grid, view);
+		grid.view.base = static_cast<GLint>(index * regionMarkers);
+		std::memcpy(mapped + grid.view.base, grid.markers.data(), grid.view.markerCount * sizeof(Marker));
+	}
+	markerStream.commit();
+}
+
+
+const ViewMarkers& get(size_t viewIndex) {
+	return (viewIndex < grids.size()) ? grids[viewIndex].view : noMarkers;
+}
+
+const Marker* markers(size_t viewIndex) {
+	return grids[viewIndex].markers.data();
+}
+
+}
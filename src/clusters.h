@@ -0,0 +1,37 @@
+#ifndef CLUSTERS_H
+#define CLUSTERS_H
+
+#include "includes.h"
+#include "constants.h"
+#include "global.h"
+
+
+
+
+namespace clusters {
+
+	//One ship, or every ship in a cell. "struct Marker" in shipMarker.vert & trail.vert (std430, bindings::SHIP_MARKERS).
+	struct Marker {
+		glm::ivec2 position;	//Viewport pixels; The ship's, or the centre of its cell.
+		GLuint count;			//Ships it stands for.
+		GLuint ship;			//Index in data::spacecraft, if count is 1.
+	};
+
+	//A view's markers; Individual ships first, then the clusters.
+	struct ViewMarkers {
+		GLint base;				//First marker in the SSBO, drawn as the base instance.
+		GLsizei shipCount;		//Individual ships (with trails).
+		GLsizei markerCount;	//Ships & clusters.
+	};
+
+
+	void initialise(); //Allocate the marker stream for data::spacecraft. Call after loading.
+	void release(); //Free the stream, while the context is still current.
+	void update(); //Once per frame, after viewports::prepare(); Re-bins the ships that changed cell, then writes every view's markers.
+	const ViewMarkers& get(size_t viewIndex);
+	const Marker* markers(size_t viewIndex); //CPU copy of the view's markers, e.g. for labels.
+
+}
+
+
+#endif
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "includes.h"
+#include "coreincludes.h"
 #include <glm/glm.hpp>
 
 
@@ -26,13 +26,48 @@ namespace constants {
 namespace sim {
 	//Simulation constants;
 	constexpr float SHIP_Gs = 1.0f;
+	constexpr double SHIP_ACCELERATION = SHIP_Gs * 9.80665e-3d; //km/s^2
 	constexpr float C = 299792.0f;
 
 	//Scaling constants
 	constexpr unsigned int PERIOD_MULTIPLIER = 86400u; //86,400 seconds in a day.
 	constexpr unsigned int SCALE_MULTIPLIER = 1000u; //Megametres, 1 unit is 1km.
 	constexpr unsigned int DEBUG_TIME_SCALING = 1u; //Debugging, speeds up time.
-	constexpr float TIME_PRECISION = 1.0f / 16.0f; //Precision to 1/16ths.
+	constexpr float TIME_PRECISION = 1.0f / 16.0f; //Precision to 1/16ths. Orbital periods are rounded to this.
+	constexpr unsigned int SINE_TABLE_BITS = 14u; //Orbit sine table entries per turn, as a power of 2. Under 3km of error at 1AU. [See phase.h]
+	constexpr unsigned int RECORDER_TIME_STEP = 600u; //Sim seconds between time-lapse frames.
+	constexpr unsigned int TRAIL_SAMPLE_INTERVAL = 60u; //Sim seconds between ship trail samples.
+	constexpr double SIM_HZ = 20.0d; //Simulation thread tick rate, independent of the frame rate.
+
+	//Telemetry [See telemetry.cpp]
+	constexpr unsigned int TELEMETRY_QUEUE_CAPACITY = 1u << 18u; //Updates between the socket threads & the simulation. ~0.25s at 1M/s.
+	constexpr time_t TELEMETRY_BLEND_TIME = 300; //Sim seconds for a correction to fade out once reports stop.
+
+	//State broadcast [See broadcast.cpp]
+	constexpr int BROADCAST_THRESHOLD = 256; //km. Positions are re-sent once this far from what clients last received.
+	constexpr int BROADCAST_QUANTUM = 16; //km per step of a relative delta. Larger moves are sent whole.
+	constexpr unsigned int BROADCAST_CLIENT_QUEUE = 8u; //Frames a client can fall behind before its queue is dropped for a keyframe.
+	constexpr size_t BROADCAST_MAX_BODIES = 1u << 16u; //Larger data is not broadcast.
+	constexpr size_t BROADCAST_MAX_SHIPS = 1u << 24u;
+	constexpr size_t BROADCAST_MAX_FRAME = 8u + ((BROADCAST_MAX_BODIES + BROADCAST_MAX_SHIPS) * 12u); //Payload bytes; Every entity sent whole. Clients disconnect on anything larger.
+
+	//Replay journal [See journal.cpp]
+	constexpr unsigned int JOURNAL_KEYFRAME_INTERVAL = 1200u; //Ticks between keyframes (one minute at SIM_HZ). Bounds the decoding per seek.
+	constexpr uint64_t JOURNAL_GROWTH = 64ull << 20u; //Bytes the journal file grows by when full.
+	constexpr uint64_t JOURNAL_RESERVE = 1ull << 40u; //Address space mapped for recording, the largest a journal can get.
+	constexpr time_t JOURNAL_SEEK_STEP = 3600; //Sim seconds per [Page Up]/[Page Down] while replaying.
+
+	//Traffic heatmap [See heatmap.cpp]
+	constexpr unsigned int HEATMAP_LEVELS = 8u; //Nested grids around the body, each HEATMAP_LEVEL_SCALE times wider than the one inside it.
+	constexpr int HEATMAP_RESOLUTION = 256; //Cells a side, per level.
+	constexpr int HEATMAP_LEVEL_SCALE = 4;
+	constexpr int64_t HEATMAP_EXTENT = 1ll << 18; //km from the body to the edge of the finest level (2048km cells). The coarsest reaches 2^32km.
+	constexpr unsigned int HEATMAP_REDUCE_TICKS = 20u; //Ticks between folding the per-thread grids into the total (one second at SIM_HZ).
+	constexpr size_t HEATMAP_PARALLEL_MIN = 16384u; //Ships before binning is split across threads.
+
+	//Arrivals & departures [See schedule.cpp]
+	constexpr time_t SCHEDULE_BUCKET_SECONDS = 60; //Sim seconds per calendar queue bucket.
+	constexpr unsigned int SCHEDULE_BUCKETS = 4096u; //The calendar wraps after this many (~68 hours). Larger jumps rebuild it.
 }
 
 namespace display {
@@ -46,17 +81,73 @@ namespace display {
 
 	//Texture Standardisation
 	constexpr glm::ivec2 TEXTURE_RESOLUTION = glm::ivec2(128, 128);
+	constexpr std::array<unsigned char, 4> TEXTURE_PLACEHOLDER_COLOUR = {96u, 96u, 96u, 255u}; //Shown until a texture has loaded.
+	constexpr double TEXTURE_UPLOAD_BUDGET_MS = 2.0d; //Per frame, spent copying decoded textures to the GPU.
+	constexpr unsigned int TEXTURE_UPLOAD_PBO_COUNT = 3u;
 
 	//Time
 	constexpr double HZ = 60.0d;
 	constexpr double DT = 1.0f/HZ;
+	constexpr unsigned int PACER_SPIN_US = 500u; //Frame limiter spins for this long before each deadline, sleeping until then.
+	constexpr double IDLE_WAIT_S = 0.5d; //Longest sleep between frames while nothing visible changes. [See redraw.cpp]
+
+	//Captures
+	constexpr unsigned int CAPTURE_PBO_COUNT = 4u; //Readbacks in flight before captures are dropped.
+	constexpr unsigned int RECORDER_FPS = 30u; //Playback rate written to time-lapse files.
+	constexpr unsigned int RECORDER_BUFFER_COUNT = 8u; //Frames held between the render thread and the writer.
+
+	//Streaming buffers
+	constexpr unsigned int STREAM_REGION_COUNT = 3u; //Frames of per-frame data the GPU can be behind before a write waits.
+
+	//Labels
+	constexpr int LABEL_SCALE = 2; //Pixels per font pixel.
+	constexpr int LABEL_GRID_CELL = 16; //Declutter grid, in pixels. A label is hidden if any cell it covers is taken.
+	constexpr glm::ivec2 LABEL_OFFSET = glm::ivec2(8, 8); //From the anchor to the label's top left.
+	constexpr unsigned int LABEL_MAX_GLYPHS = 65536u; //Per frame.
+
+	//Ship trails
+	constexpr unsigned int TRAIL_CAPACITY = 256u; //Samples kept per ship, allocated on the GPU.
+	constexpr unsigned int TRAIL_LENGTH = 128u; //Samples drawn by default, at most TRAIL_CAPACITY.
+	constexpr float TRAIL_FADE = 1.5f; //Alpha falls off as (1 - age)^TRAIL_FADE.
+
+	//Viewports [See viewports.cpp]
+	constexpr unsigned int VIEWPORT_MAX = 16u; //Views shown at once.
+	constexpr int VIEWPORT_GAP = 2; //Pixels between views.
+	constexpr int VIEWPORT_CULL_MARGIN = 4; //Pixels around a view that still count as inside it, for line & sprite edges.
+
+	//Ship clusters [See clusters.cpp]
+	constexpr int SHIP_CLUSTER_CELL = 8; //Pixels a side of the grid ships are binned into, per view.
+	constexpr unsigned int SHIP_CLUSTER_MIN = 2u; //Ships sharing a cell drawn as one marker. Fewer are drawn individually.
+
+	//Traffic heatmap [See heatmap.cpp]
+	constexpr float HEATMAP_OPACITY = 0.6f; //Of the densest cells; Sparser ones fade with the log of their density.
+
+	//Arrivals & departures boards [See schedule.cpp]
+	constexpr unsigned int BOARD_ROWS = 6u; //Of each, per body.
+}
+
+namespace bindings {
+	//Shader storage buffer binding points, shared by every shader that reads them.
+	constexpr int BODY_ELEMENTS = 0;	//Flattened orbital elements (ephemeris::BodyGPU)
+	constexpr int BODY_POSITIONS = 1;	//Evaluated body positions (ivec2)
+	constexpr int BODY_LEVEL_ORDER = 2;	//Body indices sorted by hierarchy level.
+	constexpr int SHIP_TRAILS = 3;		//Ship position history ring (trails.cpp)
+	constexpr int LABEL_GLYPHS = 4;		//This frame's label glyphs (text.cpp)
+	constexpr int VISIBLE_BODIES = 5;	//Each view's visible orbits & sprites, after culling (viewports.cpp)
+	constexpr int SHIP_MARKERS = 6;		//Each view's individual ships & ship clusters (clusters.cpp)
+	constexpr int SINE_TABLE = 7;		//Fixed point sine table for the GPU ephemeris (phase.h)
+
+	//Uniform buffer binding points.
+	constexpr int VIEW_UNIFORMS = 0;	//Per-view camera block, rebound for each viewport (viewports.cpp)
+
+	//Compute shader workgroup size.
+	constexpr unsigned int EPHEMERIS_GROUP_SIZE = 64u;
 }
 
 namespace dev {
 	//Assorted DEV/DEBUG constants
 	constexpr bool PAUSE_ON_OPENGL_ERROR = true;
-	constexpr bool SHOW_HZ_CONSOLE = false;
-	constexpr bool SHOW_DT_CONSOLE = false;
+	constexpr bool SHOW_FRAME_STATS_CONSOLE = false; //One line per frame stats summary, rather than per frame.
 	constexpr bool VSYNC = false;
 
 	//Debug
@@ -67,4 +158,28 @@ namespace dev {
 	constexpr bool SHOW_VIEWS_CONSOLE = true;
 	//Etc;
 	constexpr bool DEBUG_BODY_LOCATIONS = false;
+
+	//Ephemeris backend;
+	constexpr bool GPU_EPHEMERIS = false; //Evaluate body positions in a compute shader. Falls back to the CPU if unsupported.
+	constexpr bool VERIFY_GPU_EPHEMERIS = false; //Compare every GPU evaluation against the CPU. Stalls, debug only.
+
+	//Shader programs; Linked binaries kept in "saved.shadercache/", keyed on the sources & driver. [See graphics.cpp]
+	constexpr bool SHADER_CACHE = true;
+
+	//Profiler; Always recording, cheap enough to leave on. [See profiler.cpp]
+	constexpr unsigned int PROFILER_EVENTS = 16384u; //Scopes kept per thread.
+	constexpr unsigned int PROFILER_GPU_QUERIES = 64u; //GL_TIME_ELAPSED queries awaiting results.
+	constexpr unsigned int PROFILER_TRACE_FRAMES = 120u; //Frames written by F4, or after a hitch.
+	constexpr double PROFILER_HITCH_MS = 100.0d; //A frame this long writes a trace of the frames before it. <= 0 to disable.
+
+	//Frame stats; Rolling percentiles, written as CSV to "saved.stats/". [See framestats.cpp]
+	constexpr unsigned int FRAME_STATS_CAPACITY = 16384u; //Frames kept for the sliding windows.
+	constexpr std::array<double, 4> FRAME_STATS_WINDOWS = {1.0d, 10.0d, 60.0d, 0.0d}; //Seconds, 0 for the whole session.
+	constexpr double FRAME_STATS_INTERVAL = 10.0d; //Seconds between summaries, <= 0 for only on demand [F5] & at exit.
+
+	//Microbenchmarks, "make bench". [See bench.cpp]
+	constexpr double BENCH_WARMUP_MS = 200.0d;
+	constexpr double BENCH_MIN_REPETITION_MS = 20.0d; //Operations per repetition are chosen to take at least this long.
+	constexpr unsigned int BENCH_REPETITIONS = 15u; //Timed, the median is compared.
+	constexpr double BENCH_REGRESSION_THRESHOLD = 0.05d; //Slower than the baseline by more than this fraction is a regression.
 }
\ No newline at end of file
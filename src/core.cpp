@@ -0,0 +1,52 @@
+#include "coreincludes.h"
+#include "structs.h"
+#include "physics.h"
+#include "loader.h"
+#include "core.h"
+using namespace std;
+using namespace glm;
+
+
+
+
+namespace core {
+
+void load(const std::string& xmlFilePath) {
+	//The loader appends, and ships/routes/views point into the vectors they replace.
+	data::spacecraft.clear();
+	data::routes.clear();
+	data::views.clear();
+	data::bodies.clear();
+	data::view = nullptr;
+	std::string path = xmlFilePath;
+	loader::loadXMLdata(path);
+}
+
+
+void evaluate(time_t UTC) {
+	bodies::evaluate(UTC);
+	spacecraft::evaluate(UTC);
+}
+
+
+
+const structs::CelestialBody* body(const std::string& name) {
+	return loader::findBody(name);
+}
+
+const structs::SpaceCraft* ship(const std::string& name) {
+	for (const structs::SpaceCraft& ship : data::spacecraft) {
+		if (ship.name == name) {return &ship;}
+	}
+	return nullptr;
+}
+
+const std::vector<structs::CelestialBody>& bodies() {
+	return data::bodies;
+}
+
+const std::vector<structs::SpaceCraft>& ships() {
+	return data::spacecraft;
+}
+
+}
@@ -0,0 +1,28 @@
+#ifndef CORE_H
+#define CORE_H
+
+#include "coreincludes.h"
+#include "constants.h"
+#include "structs.h"
+
+
+
+
+//Simulation core; libstarbound_core.a/.so. ("make core")
+//Loading, evaluation & queries, with no window or graphics dependency, for embedding in services.
+//The app & benchmarks use the same library. The state lives in data::, one catalog per process.
+namespace core {
+
+	void load(const std::string& xmlFilePath); //Replaces any loaded catalog, evaluated at the current time. Throws std::runtime_error if unreadable.
+	void evaluate(time_t UTC); //Every body, then every ship, at a (scaled) UTC time.
+
+	//Queries; Valid until the next load().
+	const structs::CelestialBody* body(const std::string& name); //First with this name (Case sensitive), or nullptr.
+	const structs::SpaceCraft* ship(const std::string& name);
+	const std::vector<structs::CelestialBody>& bodies();
+	const std::vector<structs::SpaceCraft>& ships();
+
+}
+
+
+#endif
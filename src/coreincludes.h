@@ -0,0 +1,51 @@
+#ifndef COREINCLUDES_H
+#define COREINCLUDES_H
+
+
+//Everything the simulation core needs, and nothing for windows or rendering. [See core.h]
+//includes.h adds GLEW, OpenGL & GLFW on top of this for the app.
+
+
+//Include Windows.
+#ifdef __WIN32
+#include <Windows.h> //Only for windows systems (obviously). Only needed for console-specific functions, which are minimal.
+#endif
+
+
+//Include GLM.
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+
+//Include PugiXML
+#include <pugixml.hpp>
+
+
+//Include std subheaders.
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <ctime>
+#include <chrono>
+#include <vector>
+#include <array>
+#include <set>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <stdexcept>
+#include <filesystem>
+
+#endif
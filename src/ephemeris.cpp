@@ -0,0 +1,264 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "glutils.h"
+#include "graphics.h"
+#include "physics.h"
+#include "phase.h"
+#include "streaming.h"
+#include "ephemeris.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Body positions live in an SSBO (bindings::BODY_POSITIONS) which the instanced draws read.
+GPU backend : Orbital elements are uploaded once, then "ephemeris.comp" evaluates one
+              hierarchy level per dispatch (planets, then satellites, ...), so parents
+              are always written before their children read them. The fixed point maths
+              & sine table are the CPU's, so the positions match it exactly. [See phase.h]
+CPU backend : bodies::evaluate() as before, then the positions are written straight into
+              a persistently mapped stream (streaming.cpp) each frame.
+In both cases data::bodies[].position stays valid for the CPU side; on the GPU backend it
+is copied back asynchronously, so may be 1 frame behind.
+Testing on Mesa's llvmpipe (only exposes 4.5 by default);
+  LIBGL_ALWAYS_SOFTWARE=1 MESA_GL_VERSION_OVERRIDE=4.6 MESA_GLSL_VERSION_OVERRIDE=460 ./app
+with dev::VERIFY_GPU_EPHEMERIS set, to print the GPU/CPU difference every frame.
+\* -------------------------------------------------------------------------------- */
+
+
+static_assert(phase::FRACTION_BITS == 18u, "FRACTION_BITS in ephemeris.comp.");
+
+static bool gpuActive = false;
+static std::vector<GLuint> levelStarts, levelCounts; //Ranges of the level order buffer, for levels 1+.
+static std::vector<glm::ivec2> positionStaging; //Reused for uploads & readbacks.
+static streaming::StreamBuffer positionStream; //CPU backend only.
+static GLint utcLocation = -1, levelStartLocation = -1, levelCountLocation = -1;
+
+static GLuint readbackBuffer = 0u;
+static GLsync readbackFence = nullptr;
+
+
+
+static inline GLint bodyIndex(const structs::CelestialBody* body) {
+	return (body == nullptr) ? -1 : static_cast<GLint>(body - data::bodies.data());
+}
+
+static inline unsigned int bodyLevel(const structs::CelestialBody* body) {
+	//Depth in the hierarchy; Stars are 0, planets 1, satellites 2.
+	unsigned int level = 0u;
+	while (body->hasParentBody) {body = body->parent; level++;}
+	return level;
+}
+
+
+
+static void uploadPositions() {
+	if (!gpuActive) {
+		//Every frame; Into the next region of the stream, then bound in place of the SSBO.
+		glm::ivec2* positions = positionStream.map<glm::ivec2>();
+		for (size_t index=0; index<data::bodies.size(); index++) {
+			positions[index] = data::bodies[index].position;
+		}
+		positionStream.commit();
+		return;
+	}
+
+	//GPU backend, once; Static bodies are never written by the compute shader.
+	for (size_t index=0; index<data::bodies.size(); index++) {
+		positionStaging[index] = data::bodies[index].position;
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, GLIndex::bodyPositionSSBO);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, positionStaging.size() * sizeof(glm::ivec2), positionStaging.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+
+static void dispatch(time_t UTC) {
+	uint64_t time = static_cast<uint64_t>(UTC);
+	glUseProgram(GLIndex::ephemerisShader);
+	glUniform2ui(utcLocation, static_cast<GLuint>(time & 0xFFFFFFFFu), static_cast<GLuint>(time >> 32u));
+
+	for (size_t level=0; level<levelCounts.size(); level++) {
+		//Each level reads the positions written by the one above it.
+		glUniform1ui(levelStartLocation, levelStarts[level]);
+		glUniform1ui(levelCountLocation, levelCounts[level]);
+		glDispatchCompute((levelCounts[level] + bindings::EPHEMERIS_GROUP_SIZE - 1u) / bindings::EPHEMERIS_GROUP_SIZE, 1u, 1u);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT); //For the readback copy.
+	glUseProgram(0);
+}
+
+
+static void collectReadback() {
+	//Only copies once the GPU has finished, never waits.
+	if (!readbackFence) {return;}
+	GLenum status = glClientWaitSync(readbackFence, 0, 0);
+	if ((status != GL_ALREADY_SIGNALED) && (status != GL_CONDITION_SATISFIED)) {return;}
+	glDeleteSync(readbackFence);
+	readbackFence = nullptr;
+
+	glBindBuffer(GL_COPY_READ_BUFFER, readbackBuffer);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, positionStaging.size() * sizeof(glm::ivec2), positionStaging.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	for (size_t index=0; index<data::bodies.size(); index++) {
+		data::bodies[index].position = positionStaging[index];
+	}
+}
+
+static void queueReadback() {
+	if (readbackFence) {return; /* Previous copy still in flight. */}
+	glBindBuffer(GL_COPY_READ_BUFFER, GLIndex::bodyPositionSSBO);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, positionStaging.size() * sizeof(glm::ivec2));
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+
+static void verify(time_t UTC) {
+	//Debug; Compare the GPU results against the CPU for the same timestamp.
+	glGetNamedBufferSubData(GLIndex::bodyPositionSSBO, 0, positionStaging.size() * sizeof(glm::ivec2), positionStaging.data());
+	bodies::evaluate(UTC);
+
+	float maxError = 0.0f;
+	std::string worstBody = "";
+	for (size_t index=0; index<data::bodies.size(); index++) {
+		glm::vec2 delta = glm::vec2(positionStaging[index] - data::bodies[index].position);
+		float error = glm::length(delta);
+		if (error > maxError) {maxError = error; worstBody = data::bodies[index].name;}
+	}
+	std::cout << "Ephemeris GPU/CPU max error: " << maxError << "km" << ((worstBody.empty()) ? "" : " [" + worstBody + "]") << std::endl;
+}
+
+
+
+
+namespace ephemeris {
+
+void initialise() {
+	size_t count = data::bodies.size();
+	if (count == 0u) {return; /* Nothing to evaluate. */}
+	gpuActive = dev::GPU_EPHEMERIS && GLEW_VERSION_4_3; //Compute shaders & SSBOs are core in 4.3.
+	if (dev::GPU_EPHEMERIS && !gpuActive) {std::cout << "Compute shaders are unsupported, using the CPU ephemeris." << std::endl;}
+
+
+	//Flatten the hierarchy, and sort the indices by level.
+	std::vector<BodyGPU> elements(count);
+	std::vector<std::vector<GLuint>> levels;
+	for (size_t index=0; index<count; index++) {
+		structs::CelestialBody& body = data::bodies[index];
+		elements[index].colour = glm::vec4(body.colour, 1.0f);
+		elements[index].parent = (body.hasParentBody) ? bodyIndex(body.parent) : -1;
+		elements[index].radius = body.radius;
+		elements[index].orbitalRadius = body.orbitalRadius;
+		elements[index].orbitalPeriod = body.orbitalPeriod;
+		elements[index].phaseStep = glm::uvec2(static_cast<GLuint>(body.phaseStep & 0xFFFFFFFFu), static_cast<GLuint>(body.phaseStep >> 32u));
+
+		unsigned int level = bodyLevel(&body);
+		if (level == 0u) {continue; /* Static, never evaluated. */}
+		if (levels.size() < level) {levels.resize(level);}
+		levels[level - 1u].push_back(static_cast<GLuint>(index));
+	}
+
+	std::vector<GLuint> levelOrder;
+	levelOrder.reserve(count);
+	levelStarts.clear();
+	levelCounts.clear();
+	for (std::vector<GLuint>& level : levels) {
+		levelStarts.push_back(static_cast<GLuint>(levelOrder.size()));
+		levelCounts.push_back(static_cast<GLuint>(level.size()));
+		utils::combineVectors(&levelOrder, level);
+	}
+
+
+	//Elements never change after loading.
+	GLIndex::bodyElementSSBO = graphics::createShaderStorageBufferObject(bindings::BODY_ELEMENTS, count * sizeof(BodyGPU), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, GLIndex::bodyElementSSBO);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(BodyGPU), elements.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	//Positions are written every frame, by the CPU or the compute shader. Static bodies are only written here.
+	positionStaging.resize(count);
+	if (gpuActive) {
+		GLIndex::bodyPositionSSBO = graphics::createShaderStorageBufferObject(bindings::BODY_POSITIONS, count * sizeof(glm::ivec2), GL_DYNAMIC_COPY);
+	} else {
+		positionStream.create(GL_SHADER_STORAGE_BUFFER, count * sizeof(glm::ivec2), bindings::BODY_POSITIONS);
+		GLIndex::bodyPositionSSBO = positionStream.buffer();
+	}
+	uploadPositions();
+
+	if (gpuActive) {
+		GLIndex::bodyLevelOrderSSBO = graphics::createShaderStorageBufferObject(bindings::BODY_LEVEL_ORDER, std::max(levelOrder.size(), size_t(1u)) * sizeof(GLuint), GL_STATIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, GLIndex::bodyLevelOrderSSBO);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, levelOrder.size() * sizeof(GLuint), levelOrder.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		//The same table as the CPU, so both backends agree to the bit.
+		GLIndex::sineTableSSBO = graphics::createShaderStorageBufferObject(bindings::SINE_TABLE, sizeof(phase::sineTable), GL_STATIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, GLIndex::sineTableSSBO);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(phase::sineTable), phase::sineTable.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		GLIndex::ephemerisShader = graphics::createComputeShader("ephemeris.comp");
+		utcLocation = glGetUniformLocation(GLIndex::ephemerisShader, "UTC");
+		levelStartLocation = glGetUniformLocation(GLIndex::ephemerisShader, "levelStart");
+		levelCountLocation = glGetUniformLocation(GLIndex::ephemerisShader, "levelCount");
+
+		glGenBuffers(1, &readbackBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, count * sizeof(glm::ivec2), nullptr, GL_STREAM_READ);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	std::cout << "Ephemeris: " << count << " bodies over " << levels.size() << " orbiting levels, evaluated on the " << ((gpuActive) ? "GPU" : "CPU") << "." << std::endl;
+	utils::GLErrorcheck("Ephemeris initialisation", true);
+}
+
+void release() {
+	positionStream.destroy();
+}
+
+
+
+void evaluate() {
+	evaluate(utils::getTimestamp()); //Get current UTC time (seconds)
+}
+
+void evaluate(time_t UTC) {
+	if (data::bodies.empty()) {return;}
+
+	if (!gpuActive) {
+		//CPU fallback.
+		bodies::evaluate(UTC);
+		uploadPositions();
+		return;
+	}
+
+	collectReadback();
+	dispatch(UTC);
+	if constexpr (dev::VERIFY_GPU_EPHEMERIS) {verify(UTC);}
+	queueReadback();
+}
+
+
+
+void upload(time_t UTC) {
+	if (data::bodies.empty()) {return;}
+	if (!gpuActive) {uploadPositions(); return;}
+
+	collectReadback();
+	dispatch(UTC);
+	queueReadback();
+}
+
+
+
+bool usingGPU() {
+	return gpuActive;
+}
+
+}
@@ -0,0 +1,37 @@
+#ifndef EPHEMERIS_H
+#define EPHEMERIS_H
+
+#include "includes.h"
+#include "constants.h"
+
+
+
+
+namespace ephemeris {
+
+	//Flattened orbital elements of one body. Matches "struct Body" in the shaders (std430, 48 bytes).
+	struct BodyGPU {
+		glm::vec4 colour;		//Colour of its orbital line. [w unused]
+		GLint parent;			//Index of the parent in data::bodies, -1 if static.
+		GLuint radius;			//Radius of the body.
+		GLfloat orbitalRadius;	//Distance from centre to orbit.
+		GLfloat orbitalPeriod;	//Time for 1 orbit.
+		glm::uvec2 phaseStep;	//Q32.32 turns per sim second, [low, high]. [See phase.h]
+		glm::uvec2 padding;		//To the struct's 16 byte alignment.
+
+		BodyGPU() : colour(0.0f), parent(-1), radius(0u), orbitalRadius(0.0f), orbitalPeriod(0.0f), phaseStep(0u), padding(0u) {}
+	};
+	static_assert(sizeof(BodyGPU) == 48u, "std430 stride of struct Body.");
+
+
+	void initialise(); //Flatten data::bodies and upload the elements once. Call after loading.
+	void release(); //Free the position stream, while the context is still current.
+	void evaluate();   //Evaluate every body position for this frame, on the GPU or CPU.
+	void evaluate(time_t UTC); //As above, at a specific (scaled) UTC time.
+	void upload(time_t UTC); //data::bodies was already evaluated at UTC (simulation thread); Upload it, or dispatch the GPU at UTC.
+	bool usingGPU();   //Is the compute shader backend active?
+
+}
+
+
+#endif
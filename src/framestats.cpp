@@ -0,0 +1,220 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "threading.h"
+#include "framestats.h"
+#include <future>
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Nothing per frame but a few stores;
+ - Each frame is one row of a fixed ring (dev::FRAME_STATS_CAPACITY), so sliding
+   windows only reach as far back as the ring holds at the current frame rate.
+ - Every sample also goes into a session-long histogram per channel, so tail latency
+   over a long session costs a fixed amount of memory.
+ - Percentiles come from log-spaced histogram buckets (~3% wide), read at the
+   bucket's midpoint. Mean & max are exact.
+ - Summaries are CSV, appended every dev::FRAME_STATS_INTERVAL seconds (or on [F5]).
+   The render thread only copies the ring & histograms; The percentiles and the file
+   writing happen on the worker pool, so a summary is never a hitch in what it measures.
+\* -------------------------------------------------------------------------------- */
+
+
+constexpr size_t BUCKET_COUNT = 512u;
+constexpr double BUCKET_MIN_MS = 1.0e-3d, BUCKET_MAX_MS = 1.0e4d; //1us to 10s, clamped beyond.
+static const double bucketScale = BUCKET_COUNT / std::log(BUCKET_MAX_MS / BUCKET_MIN_MS);
+
+static const std::array<const char*, framestats::FS_COUNT> channelNames = {"frame", "interval", "update", "draw", "swap"};
+
+
+struct Histogram {
+	std::array<uint32_t, BUCKET_COUNT> buckets = {};
+	size_t samples = 0u;
+	double total = 0.0d, max = 0.0d;
+
+	static size_t bucket(double ms) {
+		if (ms <= BUCKET_MIN_MS) {return 0u;}
+		return std::min(static_cast<size_t>(std::log(ms / BUCKET_MIN_MS) * bucketScale), BUCKET_COUNT - 1u);
+	}
+	static double midpoint(size_t bucket) {
+		return BUCKET_MIN_MS * std::exp((bucket + 0.5d) / bucketScale);
+	}
+
+	void add(double ms) {
+		buckets[bucket(ms)]++;
+		samples++;
+		total += ms;
+		max = std::max(max, ms);
+	}
+
+	double percentile(double fraction) const {
+		size_t rank = static_cast<size_t>(std::ceil(fraction * samples));
+		size_t seen = 0u;
+		for (size_t index=0; index<BUCKET_COUNT; index++) {
+			seen += buckets[index];
+			if ((seen >= rank) && (seen > 0u)) {return std::min(midpoint(index), max);}
+		}
+		return max;
+	}
+
+	framestats::Summary summary() const {
+		framestats::Summary result;
+		if (samples == 0u) {return result;}
+		result.samples = samples;
+		result.mean = total / samples;
+		result.p50 = percentile(0.50d);
+		result.p95 = percentile(0.95d);
+		result.p99 = percentile(0.99d);
+		result.max = max;
+		return result;
+	}
+};
+
+
+struct FrameRow {
+	double time; //Seconds since start.
+	std::array<float, framestats::FS_COUNT> ms; //Negative if not sampled this frame.
+};
+
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+static std::vector<FrameRow> ring(dev::FRAME_STATS_CAPACITY);
+static size_t framesCommitted = 0u;
+static FrameRow current = {0.0d, {-1.0f, -1.0f, -1.0f, -1.0f, -1.0f}};
+static std::array<Histogram, framestats::FS_COUNT> session;
+
+//Everything a summary reads, copied for the worker pool.
+struct Stats {
+	std::vector<FrameRow> ring;
+	size_t framesCommitted = 0u;
+	std::array<Histogram, framestats::FS_COUNT> session;
+	double time = 0.0d;
+};
+
+static std::ofstream csvFile; //Worker pool, one summary at a time.
+static std::filesystem::path csvPath;
+static double nextSummary = dev::FRAME_STATS_INTERVAL;
+static Stats copied; //Read by the summary in flight, if any.
+static std::future<void> pendingSummary;
+
+
+
+static inline double secondsSinceStart() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+
+static framestats::Summary summariseRows(const std::vector<FrameRow>& rows, size_t committed, const Histogram& histogram, double now, framestats::Channel channel, double windowSeconds) {
+	if (windowSeconds <= 0.0d) {return histogram.summary();}
+
+	Histogram window;
+	double since = now - windowSeconds;
+	size_t count = std::min(committed, rows.size());
+	for (size_t back=1u; back<=count; back++) {
+		const FrameRow& row = rows[(committed - back) % rows.size()];
+		if (row.time < since) {break; /* Newest first, the rest are older. */}
+		if (row.ms[channel] >= 0.0f) {window.add(row.ms[channel]);}
+	}
+	return window.summary();
+}
+
+static framestats::Summary summariseRows(const Stats& stats, framestats::Channel channel, double windowSeconds) {
+	return summariseRows(stats.ring, stats.framesCommitted, stats.session[channel], stats.time, channel, windowSeconds);
+}
+
+
+static void writeRows(const Stats& stats) {
+	//Worker pool, or the render thread once nothing is pending.
+	if (!csvFile.is_open()) {
+		std::filesystem::path dirName = std::filesystem::path("saved.stats");
+		std::filesystem::create_directories(dirName);
+		csvPath = dirName / (utils::getTimestampStrPrecise() + ".csv");
+		csvFile.open(csvPath);
+		if (!csvFile) {std::cerr << "Could not write frame stats [" << csvPath << "]" << std::endl; return;}
+		csvFile << "time,frames,channel,window,samples,mean,p50,p95,p99,max\n";
+		csvFile << std::fixed << std::setprecision(3);
+	}
+
+	for (size_t channel=0; channel<framestats::FS_COUNT; channel++) {
+		for (double windowSeconds : dev::FRAME_STATS_WINDOWS) {
+			framestats::Summary s = summariseRows(stats, static_cast<framestats::Channel>(channel), windowSeconds);
+			if (s.samples == 0u) {continue;}
+			csvFile << stats.time << "," << stats.framesCommitted << "," << channelNames[channel] << ",";
+			if (windowSeconds > 0.0d) {csvFile << std::defaultfloat << windowSeconds << "s" << std::fixed;} else {csvFile << "session";}
+			csvFile << "," << s.samples << "," << s.mean << "," << s.p50 << "," << s.p95 << "," << s.p99 << "," << s.max << "\n";
+		}
+	}
+	csvFile.flush();
+
+	if (dev::SHOW_FRAME_STATS_CONSOLE) {
+		framestats::Summary s = summariseRows(stats, framestats::FS_FRAME, dev::FRAME_STATS_WINDOWS[0]);
+		framestats::Summary interval = summariseRows(stats, framestats::FS_INTERVAL, dev::FRAME_STATS_WINDOWS[0]);
+		std::cout << std::fixed << std::setprecision(2) << "Frame (last " << dev::FRAME_STATS_WINDOWS[0] << "s) p50 " << s.p50 << "ms / p99 " << s.p99 << "ms / max " << s.max
+				  << "ms : " << ((interval.mean > 0.0d) ? (1.0e3d / interval.mean) : 0.0d) << "Hz" << std::defaultfloat << std::endl;
+	}
+}
+
+
+static void copyStats(Stats& stats) {
+	//Into the same allocation every time; Only one summary is in flight.
+	stats.ring.assign(ring.begin(), ring.end());
+	stats.framesCommitted = framesCommitted;
+	stats.session = session;
+	stats.time = secondsSinceStart();
+}
+
+
+
+
+namespace framestats {
+
+void add(Channel channel, double ms) {
+	current.ms[channel] = static_cast<float>(ms);
+}
+
+
+void endFrame() {
+	current.time = secondsSinceStart();
+	for (size_t channel=0; channel<FS_COUNT; channel++) {
+		if (current.ms[channel] >= 0.0f) {session[channel].add(current.ms[channel]);}
+	}
+	ring[framesCommitted % ring.size()] = current;
+	framesCommitted++;
+	current.ms.fill(-1.0f);
+
+	if ((dev::FRAME_STATS_INTERVAL > 0.0d) && (current.time >= nextSummary)) {
+		writeSummary();
+		nextSummary = current.time + dev::FRAME_STATS_INTERVAL;
+	}
+}
+
+
+
+Summary summarise(Channel channel, double windowSeconds) {
+	return summariseRows(ring, framesCommitted, session[channel], secondsSinceStart(), channel, windowSeconds);
+}
+
+
+void writeSummary() {
+	//Skipped if the last one is still being written; The next is only an interval away.
+	if (pendingSummary.valid() && (pendingSummary.wait_for(std::chrono::seconds(0)) != std::future_status::ready)) {return;}
+	copyStats(copied);
+	std::shared_ptr<std::packaged_task<void()>> task = std::make_shared<std::packaged_task<void()>>([]() {writeRows(copied);});
+	pendingSummary = task->get_future();
+	threading::workers().submit([task]() {(*task)();});
+}
+
+
+void finish() {
+	if (pendingSummary.valid()) {pendingSummary.wait();}
+	if (framesCommitted == 0u) {return;}
+	copyStats(copied);
+	writeRows(copied);
+	csvFile.close();
+	std::cout << "Frame stats saved as : [" << csvPath << "]" << std::endl;
+}
+
+}
@@ -0,0 +1,37 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include "includes.h"
+#include "constants.h"
+
+
+
+
+namespace framestats {
+
+	enum Channel {
+		FS_FRAME,    //Work done in the frame, without the pacer's wait.
+		FS_INTERVAL, //Start to start, including the wait. 1 / frame rate.
+		FS_UPDATE,   //System state; Snapshot or evaluation, trails.
+		FS_DRAW,     //CPU time of the frame:: passes.
+		FS_SWAP,     //glfwSwapBuffers, includes any wait on the GPU/VSync.
+		FS_COUNT
+	};
+
+	struct Summary {
+		size_t samples = 0u;
+		double mean = 0.0d, p50 = 0.0d, p95 = 0.0d, p99 = 0.0d, max = 0.0d; //Milliseconds.
+	};
+
+
+	void add(Channel channel, double ms); //Any time during the frame, at most once per channel.
+	void endFrame(); //Commits the frame's samples, writes a summary when one is due. No I/O otherwise.
+
+	Summary summarise(Channel channel, double windowSeconds); //Over the last windowSeconds, <= 0 for the whole session.
+	void writeSummary(); //Every channel & window, as CSV rows in "saved.stats/". Copies the stats, then summarised & written on the worker pool.
+	void finish(); //Waits for any summary in flight, writes the final one, then closes the file.
+
+}
+
+
+#endif
@@ -1,6 +1,7 @@
 #pragma once
 #include "includes.h"
 #include "constants.h"
+#include "structs.h"
 using namespace std;
 
 
@@ -12,6 +13,16 @@ inline std::unordered_map<int, bool> keyMap = {
 	{GLFW_KEY_ESCAPE, false},
 	{GLFW_KEY_E, false}, //Next view
 	{GLFW_KEY_Q, false}, //Previous view
+	{GLFW_KEY_R, false}, //Toggle time-lapse recording
+	{GLFW_KEY_F2, false}, //Screenshot
+	{GLFW_KEY_F3, false}, //Toggle continuous capture
+	{GLFW_KEY_F4, false}, //Trace the last few frames (profiler)
+	{GLFW_KEY_F5, false}, //Write a frame stats summary
+	{GLFW_KEY_F6, false}, //Export the traffic heatmap
+	{GLFW_KEY_H, false}, //Toggle the traffic heatmap overlay
+	{GLFW_KEY_B, false}, //Toggle the arrivals & departures boards
+	{GLFW_KEY_PAGE_UP, false}, //Replay; Seek forwards
+	{GLFW_KEY_PAGE_DOWN, false}, //Replay; Seek backwards
 };
 inline std::unordered_map<int, bool> previousKeyMap = {};
 inline glm::dvec2 cursorPosition, cursorPositionPrevious, cursorDelta;
@@ -25,7 +36,6 @@ inline unsigned int frameNumber;
 
 inline float globalScaling = 1.0e-6f;     //Camera zoom
 inline glm::ivec2 globalOffset = glm::ivec2(0, 0); //Camera translation
-inline unsigned int simSpeed = 1u;
 
 
 namespace GLIndex {
@@ -33,135 +43,10 @@ namespace GLIndex {
 //Any indices required for OpenGL stuff.
 inline GLint genericVAO;
 inline GLuint r1CircleVAO, r1CircleVBO, orbitLineShader, spriteShader;
+inline GLuint ephemerisShader, bodyElementSSBO, bodyPositionSSBO, bodyLevelOrderSSBO, sineTableSSBO;
+inline GLuint trailShader, trailSSBO, shipMarkerShader;
+inline GLuint textShader, glyphAtlas;
+inline GLuint layerShader, heatmapShader;
 inline glm::mat4 projectionMatrix;
 
 }
-
-
-
-
-enum CelestialType {
-	CT_INVALID,   //Not a valid type.
-	CT_STAR,      //Anything stationary.
-	CT_PLANET,    //Anything orbiting a star.
-	CT_SATELLITE, //Moons, Stations, anything orbiting a planet.
-	CT_GATE       //Gates to other stars. Transports ships "instantly" (like teleporting but better)
-};
-
-
-namespace structs {
-
-
-//Star/Planet/Satellite
-struct CelestialBody {
-	std::string name;    	//Body name.
-	CelestialType type;		//What sort of body?
-	glm::ivec2 position;  	//Current position.
-	unsigned int radius;	//Radius of the body.
-	glm::vec3 colour;		//Colour of its orbital line.
-
-	bool hasParentBody;		//Should orbit around some parent body?
-	CelestialBody* parent;	//Star to orbit around.
-	float orbitalRadius; 	//Distance from centre to orbit.
-	float orbitalPeriod; 	//Time for 1 orbit.
-	float progress;			//0-1 of orbit completed.
-
-	std::vector<CelestialBody*> children; //Child bodies.
-
-	CelestialBody()
-		 : name("<BODY_INVALID>"), type(CT_INVALID), position(0.0f, 0.0f), colour(0.0f, 0.0f, 0.0f),
-		   radius(0.0f), hasParentBody(false), parent(nullptr), orbitalRadius(0.0f), orbitalPeriod(0.0f), children() {}
-	CelestialBody(std::string n, CelestialType t, glm::vec2 pos, glm::vec3 c, unsigned int bR, float oR, float p, CelestialBody* parent=nullptr)
-		 : name(n), type(t), position(pos), colour(c), radius(bR), hasParentBody(parent != nullptr), parent(parent), orbitalRadius(oR), orbitalPeriod(p), children() {}
-};
-
-
-//Static route information.
-struct Route {
-	std::string number; 					//E.g. "BTN-7274"
-	std::vector<CelestialBody*> locations;  //List of places to go.
-
-	Route() : number("<ROUTE_INVALID>"), locations() {}
-	Route(std::string n, std::vector<CelestialBody*> l)
-		 : number(n), locations(l) {}
-};
-
-
-//Contains flight data.
-struct Flight {
-	CelestialBody* startBody;	//Start
-	glm::ivec2 startPos; 		//Where was the start when the journey began?
-	CelestialBody* endBody;		//Destination
-	glm::ivec2 endPos;			//Where will it intercept the destination?
-	unsigned int ETA; 			//UTF ETA.
-	float progress;     		//0-1 of journey completed. Based on time, NOT distance.
-	std::string number; 		//E.g. "BTN-7274"
-
-	Flight() : startBody(nullptr), endBody(nullptr), number("<FLIGHT_INVALID>") {}
-	Flight(CelestialBody* s, CelestialBody* e, std::string n)
-		 : startBody(s), endBody(e), number(n) {}
-};
-
-
-//A single spacecraft.
-struct SpaceCraft {
-	std::string name;    //Spacecraft name.
-	Flight journey;      //Current journey.
-	Route* route;	     //The route it follows.
-	float speed;	     //Current speed.
-	glm::ivec2 position; //Current position.
-
-	SpaceCraft() : name("<SHIP_INVALID>"), journey(), route(nullptr), speed(0.0f) {}
-	SpaceCraft(std::string n, Route* r)
-		 : name(n), journey(), route(r), speed(0.0f) {}
-
-	float& getSpeed() {
-		glm::ivec2 delta = this->journey.endPos - this->journey.startPos;
-		float distance = sqrt((delta.x*delta.x) + (delta.y+delta.y)); //glm::length doesn't accept ivec for some reason.
-		float progress = this->journey.progress;
-		if (progress < 0.5f) {
-			//Accelerating
-			this->speed = sim::SHIP_Gs * progress * distance;
-		} else {
-			//Deccelerating
-			this->speed = (distance * sim::SHIP_Gs) * (1.0f - progress);
-		}
-		return this->speed;
-	}
-
-	glm::ivec2& getPosition() {
-		//Calculate current position given the progress through the journey.
-		return this->position;
-	}
-};
-
-
-
-//Camera view (Scale, Body to centre on)
-struct CameraView {
-	std::string name;		  //Name or short identified for the view.
-	CelestialBody* focusBody; //Body to centre view on.
-	float scale;			  //Scaling of distances.
-	glm::ivec2 offset;        //Camera offset from the body.
-
-	CameraView() : name("<VIEW_INVALID>"), focusBody(nullptr), scale(0.0f), offset(0, 0) {}
-	CameraView(std::string n, CelestialBody* cb, float s, glm::ivec2 o)
-		 : name(n), focusBody(cb), scale(s), offset(o) {}
-};
-
-}
-
-
-
-//All sim data.
-namespace data {
-	inline std::vector<structs::CelestialBody> bodies = {};
-	inline std::vector<structs::Route> routes = {};
-	inline std::vector<structs::SpaceCraft> spacecraft = {};
-
-	inline unsigned int currentCameraViewIndex = 0u;
-	inline std::vector<structs::CameraView> views = {};
-	inline structs::CameraView* view = nullptr;
-}
-
-
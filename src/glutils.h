@@ -0,0 +1,25 @@
+#ifndef GLUTILS_H
+#define GLUTILS_H
+
+#include "includes.h"
+#include "utils.h"
+
+
+
+
+//OpenGL utility functions, apart from utils.h which the simulation core uses without OpenGL.
+namespace utils {
+	static inline void GLErrorcheck(std::string location = "", bool shouldPause = false) {
+		GLenum GLError;
+		GLError = glGetError();
+		if (GLError != GL_NO_ERROR) {
+			if (!utils::isConsoleVisible()) {
+				utils::showConsole();
+			}
+			std::cerr << location << " | OpenGL error; " << GLError << std::endl;
+			if (shouldPause) {pause();}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,72 @@
+#include "includes.h"
+#include "global.h"
+#include "profiler.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+GPU half of the profiler; A pool of GL_TIME_ELAPSED queries, one per GPUScope.
+Kept apart from profiler.cpp so the simulation core links without OpenGL.
+Results are collected oldest first once available (a few frames later), through
+the collector registered with profiler::setGPUCollector() on the first scope.
+\* -------------------------------------------------------------------------------- */
+
+
+struct PendingQuery {
+	GLuint query = 0u;
+	const char* name = nullptr;
+	int64_t start = 0;
+	unsigned long long frame = 0u;
+	bool active = false;
+};
+
+static std::array<PendingQuery, dev::PROFILER_GPU_QUERIES> queries;
+static size_t queryHead = 0u;
+
+
+
+static void collectQueries(bool wait) {
+	//Oldest first, stops at the first result not yet available.
+	for (size_t checked=0; checked<queries.size(); checked++) {
+		PendingQuery& pending = queries[(queryHead + checked) % queries.size()];
+		if (!pending.active) {continue;}
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available && !wait) {break;}
+		GLuint64 elapsed = 0u;
+		glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &elapsed);
+		profiler::recordGPU(pending.name, pending.start, static_cast<int64_t>(elapsed), pending.frame);
+		pending.active = false;
+	}
+}
+
+
+
+
+namespace profiler {
+
+GPUScope::GPUScope(const char* name) : cpu(name), query(-1) {
+	static bool registered = false;
+	if (!registered) {setGPUCollector(collectQueries); registered = true;}
+
+	size_t slot = queryHead;
+	if (queries[slot].active) {return; /* Pool full of unread results, skip rather than wait. */}
+	PendingQuery& next = queries[slot];
+	if (!next.query) {glGenQueries(1, &next.query);}
+	next.name = name;
+	next.start = now();
+	next.frame = currentFrame();
+	glBeginQuery(GL_TIME_ELAPSED, next.query);
+	query = static_cast<int>(slot);
+	queryHead = (queryHead + 1u) % queries.size();
+}
+
+GPUScope::~GPUScope() {
+	if (query < 0) {return;}
+	glEndQuery(GL_TIME_ELAPSED);
+	queries[query].active = true;
+}
+
+}
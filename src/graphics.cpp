@@ -1,6 +1,17 @@
 #include "includes.h"
 #include "global.h"
 #include "utils.h"
+#include "glutils.h"
+#include "capture.h"
+#include "textures.h"
+#include "trails.h"
+#include "text.h"
+#include "profiler.h"
+#include "viewports.h"
+#include "layers.h"
+#include "clusters.h"
+#include "heatmap.h"
+#include "schedule.h"
 #include <stb_image.h>
 #include <stb_image_write.h>
 using namespace std;
@@ -63,8 +74,8 @@ void APIENTRY openGLErrorCallback(
 
 
 
-GLuint compileShader(GLenum shaderType, string filePath) {
-	std::string source = utils::readFile(filePath);
+GLuint compileShader(GLenum shaderType, const std::string& source) {
+	PROFILE_SCOPE("compileShader");
 	const char* src = source.c_str();
 
 	GLuint shader = glCreateShader(shaderType);
@@ -94,6 +105,173 @@ GLuint compileShader(GLenum shaderType, string filePath) {
 
 
 
+//// PROGRAM CACHE ////
+//"saved.shadercache/<stage+stage>.bin"; Header, then the driver's program binary. Stale once any
+//stage's source or the driver (vendor, renderer, version) changes, then rebuilt from source.
+struct ProgramCacheHeader {
+	char magic[4] = {'S', 'B', 'S', 'H'};
+	uint32_t version = 1u;
+	uint64_t key = 0u; //programKey()
+	uint32_t format = 0u; //GL_PROGRAM_BINARY_FORMATS, as the driver returned it.
+	uint32_t length = 0u;
+};
+
+struct ShaderStage {
+	GLenum type;
+	std::string name; //In "src/shaders/".
+	std::string source;
+};
+
+static inline uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t index=0; index<size; index++) {hash = (hash ^ bytes[index]) * 0x100000001b3ull;}
+	return hash;
+}
+
+static uint64_t programKey(const std::vector<ShaderStage>& stages) {
+	//Every stage's type & source, then the driver strings; A binary is only valid for the driver that made it.
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (const ShaderStage& stage : stages) {
+		hash = fnv1a(hash, &stage.type, sizeof(stage.type));
+		uint64_t length = stage.source.size();
+		hash = fnv1a(hash, &length, sizeof(length));
+		hash = fnv1a(hash, stage.source.data(), stage.source.size());
+	}
+	for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+		const GLubyte* text = glGetString(name);
+		std::string value = (text) ? reinterpret_cast<const char*>(text) : "";
+		hash = fnv1a(hash, value.data(), value.size() + 1u); //With the terminator, so the strings cannot run together.
+	}
+	return hash;
+}
+
+static const std::vector<GLint>& binaryFormats() {
+	//Queried once; Empty if the driver cannot save programs.
+	static const std::vector<GLint> formats = [](){
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+		std::vector<GLint> list(static_cast<size_t>(std::max(count, 0)));
+		if (!list.empty()) {glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, list.data());}
+		return list;
+	}();
+	return formats;
+}
+
+static bool binariesSupported() {
+	return dev::SHADER_CACHE && !binaryFormats().empty();
+}
+
+static std::filesystem::path programCachePath(const std::vector<ShaderStage>& stages) {
+	std::string name;
+	for (const ShaderStage& stage : stages) {name += ((name.empty()) ? "" : "+") + stage.name;}
+	return std::filesystem::path("saved.shadercache") / (name + ".bin");
+}
+
+static GLuint readProgramCache(const std::vector<ShaderStage>& stages, uint64_t key) {
+	//0 if missing, stale, or the driver rejects it.
+	PROFILE_SCOPE("readProgramCache");
+	std::ifstream file(programCachePath(stages), std::ios::binary);
+	if (!file) {return 0u;}
+
+	ProgramCacheHeader header, expected;
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (
+		!file ||
+		(std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) ||
+		(header.version != expected.version) ||
+		(header.key != key) ||
+		(header.length == 0u)
+	) {return 0u; /* Missing, old format or stale. */}
+	const std::vector<GLint>& formats = binaryFormats();
+	if (std::find(formats.begin(), formats.end(), static_cast<GLint>(header.format)) == formats.end()) {return 0u; /* Would be GL_INVALID_ENUM, not a quiet fallback. */}
+
+	std::vector<char> binary(header.length);
+	file.read(binary.data(), binary.size());
+	if (!file) {return 0u; /* Truncated. */}
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, static_cast<GLenum>(header.format), binary.data(), static_cast<GLsizei>(binary.size()));
+	GLint success = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success) {glDeleteProgram(program); return 0u; /* Driver updated in place, or a format it no longer takes. */}
+	return program;
+}
+
+static void writeProgramCache(GLuint program, const std::vector<ShaderStage>& stages, uint64_t key) {
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {return; /* Caching is optional. */}
+	std::vector<char> binary(static_cast<size_t>(length));
+	GLenum format = 0u;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+	if (length <= 0) {return;}
+
+	std::filesystem::path path = programCachePath(stages);
+	std::filesystem::path temporary = path;
+	temporary += ".tmp";
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+
+	ProgramCacheHeader header;
+	header.key = key;
+	header.format = static_cast<uint32_t>(format);
+	header.length = static_cast<uint32_t>(length);
+	bool written = false;
+	{
+		std::ofstream file(temporary, std::ios::binary);
+		if (!file) {return;}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), header.length);
+		file.close();
+		written = !file.fail();
+	}
+	if (written) {std::filesystem::rename(temporary, path, error); /* Never leave a half-written cache behind. */}
+	if (!written || error) {std::filesystem::remove(temporary, error);}
+}
+//// PROGRAM CACHE ////
+
+
+
+static GLuint buildProgram(std::vector<ShaderStage> stages, const std::string& failure) {
+	//From the cache when it is current, otherwise compiled & linked from source, then cached.
+	for (ShaderStage& stage : stages) {stage.source = utils::readFile("src/shaders/" + stage.name);}
+	bool cached = binariesSupported();
+	uint64_t key = (cached) ? programKey(stages) : 0u;
+	if (cached) {
+		GLuint program = readProgramCache(stages, key);
+		if (program != 0u) {return program;}
+	}
+
+	std::vector<GLuint> shaders;
+	for (const ShaderStage& stage : stages) {shaders.push_back(compileShader(stage.type, stage.source));}
+
+	GLuint shaderProgram = glCreateProgram();
+	for (GLuint shader : shaders) {glAttachShader(shaderProgram, shader);}
+	if (cached) {glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);}
+	glLinkProgram(shaderProgram);
+
+	GLint success;
+	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+	if (!success) {
+		if (!utils::isConsoleVisible()) {
+			utils::showConsole();
+		}
+		char infolog[512];
+		glGetProgramInfoLog(shaderProgram, 512, nullptr, infolog);
+		raise(failure + "\n" + string(infolog));
+	}
+
+	for (GLuint shader : shaders) {
+		glDetachShader(shaderProgram, shader);
+		glDeleteShader(shader);
+	}
+	if (cached) {writeProgramCache(shaderProgram, stages, key);}
+
+	return shaderProgram;
+}
+
+
+
 
 namespace uniforms {
 
@@ -203,55 +381,14 @@ GLFWwindow* initialiseWindow(glm::ivec2 resolution, const char* title) {
 
 
 GLuint createShaderProgram(std::string fragShaderName, std::string vertexShaderName) {
-	GLuint vertexShader = compileShader(GL_VERTEX_SHADER, "src/shaders/"+ vertexShaderName);
-	GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, "src/shaders/"+ fragShaderName);
-
-	GLuint shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-
-	GLint success;
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-	if (!success) {
-		if (!utils::isConsoleVisible()) {
-			utils::showConsole();
-		}
-		char infolog[512];
-		glGetProgramInfoLog(shaderProgram, 512, nullptr, infolog);
-		raise("Error: Program linking failed;\n" + string(infolog));
-	}
-
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-
-	return shaderProgram;
+	return buildProgram({{GL_VERTEX_SHADER, vertexShaderName, ""}, {GL_FRAGMENT_SHADER, fragShaderName, ""}}, "Error: Program linking failed;");
 }
 
 
 
 
 GLuint createComputeShader(std::string compShaderName) {
-	GLuint computeShader = compileShader(GL_COMPUTE_SHADER, "src/shaders/" + compShaderName);
-
-	GLuint shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, computeShader);
-	glLinkProgram(shaderProgram);
-
-	GLint success;
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-	if (!success) {
-		if (!utils::isConsoleVisible()) {
-			utils::showConsole();
-		}
-		char infolog[512];
-		glGetProgramInfoLog(shaderProgram, 512, nullptr, infolog);
-		raise("Error: Compute shader program linking failed:\n" + std::string(infolog));
-	}
-
-	glDeleteShader(computeShader);
-
-	return shaderProgram;
+	return buildProgram({{GL_COMPUTE_SHADER, compShaderName, ""}}, "Error: Compute shader program linking failed:");
 }
 
 
@@ -274,19 +411,18 @@ void updateShaderStorageBufferObject(
 		GLuint SSBO, std::vector<TCPU>* dataSetIn, int allocSize
 	) {
 
-	size_t singleItemSize = sizeof(TGPU);
-	size_t size = (allocSize == -1) ? dataSetIn->size() : allocSize;
-	std::vector<TGPU> dataSet;
-
-	for (size_t index=0; index<size; index++) {
-		dataSet.push_back(TGPU(*(dataSetIn->data() + index)));
-	}
+	//For one-off static uploads; Per-frame data is written into a streaming::StreamBuffer instead. [See streaming.h]
+	//Converted straight into the mapped range, without a temporary.
+	size_t size = (allocSize == -1) ? dataSetIn->size() : std::min(static_cast<size_t>(allocSize), dataSetIn->size());
+	if (size == 0u) {return;}
 
-	if (size > 0 && !dataSet.empty()) {
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO);
-		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, singleItemSize * size, dataSet.data());
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO);
+	TGPU* destination = static_cast<TGPU*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, sizeof(TGPU) * size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+	if (destination) {
+		for (size_t index=0; index<size; index++) {new (destination + index) TGPU((*dataSetIn)[index]);}
+		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
 //Overload of the above without the size specified.
@@ -294,10 +430,10 @@ template<typename TGPU, typename TCPU>
 void updateShaderStorageBufferObject(
 		GLuint SSBO, std::vector<TCPU>* dataSetIn
 	) {
-	updateShaderStorageBufferObject(SSBO, dataSetIn, dataSetIn->size());
+	updateShaderStorageBufferObject<TGPU, TCPU>(SSBO, dataSetIn, -1);
 }
 
-//Same type for CPU & GPU.
+//Same type for CPU & GPU. One-off static uploads, as above.
 template<typename T>
 void updateShaderStorageBufferObject(
 	GLuint SSBO,
@@ -317,27 +453,8 @@ void updateShaderStorageBufferObject(
 
 //// TEXTURES ////
 void saveImage(GLuint textureID, bool silent=false) {
-    std::vector<unsigned char> pixels(currentRenderResolution.x * currentRenderResolution.y * 3u);
-
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-	stbi_flip_vertically_on_write(true);
-
-	std::filesystem::path dirName = std::filesystem::path("saved.images");
-	std::filesystem::create_directories(dirName);
-
-	std::string timeStr = utils::getTimestampStr();
-	std::filesystem::path imagePath = dirName / (timeStr + ".png");
-
-	stbi_write_png(
-		imagePath.string().c_str(),
-		currentRenderResolution.x, currentRenderResolution.y,
-		3u, pixels.data(), currentRenderResolution.x*3u
-	);
-
-	if (!silent) {std::cout << "Successfully saved image as : [" << imagePath << "]" << std::endl;}
+	//Asynchronous; Read back through the PBO ring, then encoded on the worker pool. [See capture.cpp]
+	capture::saveTexturePNG(textureID, currentRenderResolution, silent);
 }
 
 
@@ -361,92 +478,14 @@ GLuint createGLImage2D(size_t width, size_t height, GLint internalFormat=GL_RGBA
 
 
 GLuint loadGLTexture2D(const std::string textureName, glm::ivec2 expectedRes=glm::ivec2(-1, -1)) {
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_2D, textureID);
-
-	int width, height, channels;
-	std::string texturePath = "textures/" + textureName + ".png";
-	unsigned char* textureData = stbi_load(
-		texturePath.c_str(),
-		&width, &height,
-		&channels, 4
-	);
-
-	if (
-		!textureData ||
-		((expectedRes.x != -1) && (width != expectedRes.x)) ||
-		((expectedRes.y != -1) && (height != expectedRes.y))
-	) { //If not valid image path or wrong res.
-		std::cout << "Failed to load texture : " << textureName << ".png : Image was not found/correct resolution." << std::endl;
-		std::cerr << "Expected [" << expectedRes.x << ", " << expectedRes.y << "] : Got [" << width << ", " << height << "]" << std::endl;
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glDeleteTextures(1, &textureID);
-		return 0;
-	}
-
-
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, textureData);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	stbi_image_free(textureData);
-
-	return textureID;
+	//Asynchronous; A placeholder until decoded on the worker pool and uploaded. [See textures.cpp]
+	return textures::request2D(textureName, expectedRes);
 }
 
 
 GLuint createTexture2DArray(std::vector<std::string>& textureNames, glm::ivec2 expectedRes=display::TEXTURE_RESOLUTION) {
-	GLuint sheetArrayID;
-	glGenTextures(1, &sheetArrayID);
-	glBindTexture(GL_TEXTURE_2D_ARRAY, sheetArrayID);
-
-
-	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, expectedRes.x, expectedRes.y, textureNames.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT); //Textures repeat UV.
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT); // ^ ^ ^ ^ ^ ^ ^ ^ ^
-	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE); //Clamp to nearest layer
-
-
-	int width, height, channels;
-	int layerIndex = -1;
-	for (const std::string& textureName : textureNames) {
-		layerIndex++;
-		if (layerIndex >= textureNames.size()) {break; /* Reached final layer. */}
-		if (textureName.empty()) {continue; /* Ignore blank entries. */}
-
-		std::string texturePath = "textures/" + textureName;
-		unsigned char* textureData = stbi_load(
-			texturePath.c_str(),
-			&width, &height,
-			&channels, 4 //RGBA, 4 channels.
-		);
-
-		if (
-			!textureData ||
-			((expectedRes.x != -1) && (width != expectedRes.x)) ||
-			((expectedRes.y != -1) && (height != expectedRes.y))
-		) { //Could not find, or was wrong res.
-			std::cerr << "Could not find: [" << ("textures/" + textureName) << "]." << std::endl;
-			stbi_image_free(textureData);
-			continue; //Invalid layer.
-		}
-
-		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layerIndex, expectedRes.x, expectedRes.y, 1, GL_RGBA, GL_UNSIGNED_BYTE, textureData);
-
-	}
-
-	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
-
-	return sheetArrayID;
+	//Asynchronous, as above. Each layer loads independently.
+	return textures::request2DArray(textureNames, expectedRes);
 }
 
 
@@ -572,6 +611,7 @@ GLuint createAtomicCounter(unsigned int binding) {
 namespace orbits {
 
 #define NUM_LINE_SEGMENTS 512u
+#define HIGHLIGHT_VERTICES 88u //Arc around the body; Covers orbitLines.frag's MAX_RANGE (~41.2 segments) on either side.
 void createR1CircleVBO() {
 	std::vector<glm::vec2> circleVertices;
 	for (unsigned int i=0u; i<NUM_LINE_SEGMENTS; i++) {
@@ -601,21 +641,58 @@ void createR1CircleVBO() {
 
 
 
-void drawOrbit(structs::CelestialBody* body) {
-	if (!body->hasParentBody) {return; /* No orbit line to draw. */}
+static layers::Layer staticLayer; //Rings fixed relative to each view's focus, cached. [See layers.cpp]
+
+static void drawStatic(size_t viewIndex) {
+	//Into the cached layer, without highlights; The program & VAO are bound by drawOrbits().
+	viewports::bind(viewIndex, true);
+	glDrawArraysInstanced(GL_LINE_LOOP, 0, NUM_LINE_SEGMENTS, viewports::get(viewIndex).staticCount);
+	profiler::countDraws();
+}
+
+
+void drawOrbits() {
+	//Every visible orbit line, in a few instanced calls per view. [See viewports.cpp]
+	//Static rings come from the cached layer, only redrawn when their view changes; Moving rings & the highlight arcs are drawn every frame.
+	static std::vector<layers::ViewKey> keys;
+	keys.clear();
+	for (size_t index=0; index<viewports::count(); index++) {
+		const structs::CameraView& view = viewports::view(index);
+		keys.push_back({view.focusBody, view.scale, view.offset, viewports::rectangle(index), viewports::get(index).staticCount});
+	}
+
+	glUseProgram(GLIndex::orbitLineShader);
+	glBindVertexArray(GLIndex::r1CircleVAO);
+	profiler::countStateChanges(2u); //Program, VAO.
+	uniforms::bindUniformValue(GLIndex::orbitLineShader, "mode", 1);
+	layers::refresh(staticLayer, keys, drawStatic);
+	layers::composite(staticLayer);
+
 	glUseProgram(GLIndex::orbitLineShader);
 	glBindVertexArray(GLIndex::r1CircleVAO);
-	uniforms::bindUniformValue(GLIndex::orbitLineShader, "centre", body->parent->position - data::view->focusBody->position);
-	uniforms::bindUniformValue(GLIndex::orbitLineShader, "radius", body->orbitalRadius);
-	uniforms::bindUniformValue(GLIndex::orbitLineShader, "bodyPosition", body->position);
-	uniforms::bindUniformValue(GLIndex::orbitLineShader, "scaling", data::view->scale);
-	uniforms::bindUniformValue(GLIndex::orbitLineShader, "offset", data::view->offset);
-	uniforms::bindUniformValue(GLIndex::orbitLineShader, "projectionMatrix", GLIndex::projectionMatrix);
-	uniforms::bindUniformValue(GLIndex::orbitLineShader, "resolution", static_cast<glm::ivec2>(currentRenderResolution));
-	uniforms::bindUniformValue(GLIndex::orbitLineShader, "colour", body->colour);
-
-	//Draw the circle.
-	glDrawArrays(GL_LINE_LOOP, 0, NUM_LINE_SEGMENTS);
+	profiler::countStateChanges(2u); //Program, VAO.
+
+	//Moving rings, whole.
+	uniforms::bindUniformValue(GLIndex::orbitLineShader, "mode", 0);
+	for (size_t index=0; index<viewports::count(); index++) {
+		GLsizei orbitCount = viewports::get(index).orbitCount;
+		if (orbitCount == 0) {continue;}
+		viewports::bind(index);
+		glDrawArraysInstanced(GL_LINE_LOOP, 0, NUM_LINE_SEGMENTS, orbitCount);
+		profiler::countDraws();
+	}
+
+	//Highlight arcs over the cached rings.
+	uniforms::bindUniformValue(GLIndex::orbitLineShader, "mode", 2);
+	uniforms::bindUniformValue(GLIndex::orbitLineShader, "arcVertices", static_cast<int>(HIGHLIGHT_VERTICES));
+	for (size_t index=0; index<viewports::count(); index++) {
+		GLsizei staticCount = viewports::get(index).staticCount;
+		if (staticCount == 0) {continue;}
+		viewports::bind(index);
+		glDrawArraysInstanced(GL_LINE_STRIP, 0, HIGHLIGHT_VERTICES, staticCount);
+		profiler::countDraws();
+	}
+	viewports::unbind();
 	glBindVertexArray(0);
 }
 
@@ -634,6 +711,12 @@ void prepareOpenGL() {
 
 	GLIndex::orbitLineShader = createShaderProgram("orbitLines.frag", "orbitLines.vert");
 	GLIndex::spriteShader = createShaderProgram("sprite.frag", "sprite.vert");
+	GLIndex::trailShader = createShaderProgram("trail.frag", "trail.vert");
+	GLIndex::shipMarkerShader = createShaderProgram("shipMarker.frag", "shipMarker.vert");
+	GLIndex::textShader = createShaderProgram("text.frag", "text.vert");
+	GLIndex::layerShader = createShaderProgram("layer.frag", "layer.vert");
+	GLIndex::heatmapShader = createShaderProgram("heatmap.frag", "layer.vert"); //Same full view quad.
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); //Trails & labels fade.
 
 	orbits::createR1CircleVBO();
 	GLIndex::projectionMatrix = glm::ortho(0.0f, float(currentRenderResolution.x), 0.0f, float(currentRenderResolution.y), -1.0f, 1.0f);
@@ -661,6 +744,8 @@ inline void renderingGeneric(const std::string& shaderName="") {
 	glBindVertexArray(GLIndex::genericVAO);
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 	glBindVertexArray(0);
+	profiler::countDraws();
+	profiler::countStateChanges(1u); //VAO.
 
 	if (!shaderName.empty()) {
 		utils::GLErrorcheck(shaderName, true);
@@ -671,30 +756,182 @@ inline void renderingGeneric(const std::string& shaderName="") {
 
 void bodies() {
 	//Draw the "background", of the Stars/Planets/Moons/Satellites.
+	//Positions are read from the body SSBOs (see ephemeris.cpp), so everything is instanced.
+	//Each view draws only the bodies left after culling. [See viewports.cpp]
+	if (data::bodies.empty()) {return;}
+
+	//Draw the orbital line for each;
 	glLineWidth(2.5f);
-	for (structs::CelestialBody& body : data::bodies) {
-		//Draw the orbital line for each;
-		graphics::orbits::drawOrbit(&body);
-		//Draw the sprite for each;
-
-		glUseProgram(GLIndex::spriteShader);
-		uniforms::bindUniformValue(GLIndex::spriteShader, "centre", body.position - data::view->focusBody->position);
-		uniforms::bindUniformValue(GLIndex::spriteShader, "radius", body.radius);
-		uniforms::bindUniformValue(GLIndex::spriteShader, "scaling", data::view->scale);
-		uniforms::bindUniformValue(GLIndex::spriteShader, "offset", data::view->offset);
-		uniforms::bindUniformValue(GLIndex::spriteShader, "projectionMatrix", GLIndex::projectionMatrix);
-		uniforms::bindUniformValue(GLIndex::spriteShader, "resolution", static_cast<glm::ivec2>(currentRenderResolution));
-		renderingGeneric("spriteShader");
-		glUseProgram(0);
-	}
+	graphics::orbits::drawOrbits();
 	glLineWidth(1.0f);
+
+	//Draw the sprite for each;
+	glUseProgram(GLIndex::spriteShader);
+	glBindVertexArray(GLIndex::genericVAO);
+	profiler::countStateChanges(2u); //Program, VAO.
+	for (size_t index=0; index<viewports::count(); index++) {
+		GLsizei spriteCount = viewports::get(index).spriteCount;
+		if (spriteCount == 0) {continue;}
+		viewports::bind(index);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, spriteCount);
+		profiler::countDraws();
+	}
+	viewports::unbind();
+	glBindVertexArray(0);
+	glUseProgram(0);
+	utils::GLErrorcheck("spriteShader", true);
+}
+
+void heatmap() {
+	//Accumulated ship traffic around one body, one full view quad per view under the ships. [See heatmap.cpp]
+	if (!heatmap::visible()) {return;}
+	glUseProgram(GLIndex::heatmapShader);
+	uniforms::bindUniformValue(GLIndex::heatmapShader, "body", heatmap::current().body);
+	uniforms::bindUniformValue(GLIndex::heatmapShader, "levels", static_cast<int>(sim::HEATMAP_LEVELS));
+	uniforms::bindUniformValue(GLIndex::heatmapShader, "cells", sim::HEATMAP_RESOLUTION);
+	uniforms::bindUniformValue(GLIndex::heatmapShader, "extent", static_cast<float>(sim::HEATMAP_EXTENT));
+	uniforms::bindUniformValue(GLIndex::heatmapShader, "levelScale", static_cast<float>(sim::HEATMAP_LEVEL_SCALE));
+	uniforms::bindUniformValue(GLIndex::heatmapShader, "maxDensity", heatmap::current().maxDensity);
+	uniforms::bindUniformValue(GLIndex::heatmapShader, "opacity", display::HEATMAP_OPACITY);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, heatmap::texture());
+	glBindVertexArray(GLIndex::genericVAO);
+	profiler::countStateChanges(3u); //Program, texture, VAO.
+	for (size_t index=0; index<viewports::count(); index++) {
+		viewports::bind(index);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		profiler::countDraws();
+	}
+	viewports::unbind();
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	glUseProgram(0);
+	utils::GLErrorcheck("heatmapShader", true);
 }
 
 void spacecraft() {
 	//Draw the "notable" objects, the spacecraft flying around.
-	//TBA.
+	//Each view's ships are binned into clusters where they crowd together; Only the ships drawn individually get trails. [See clusters.cpp]
+	if (data::spacecraft.empty()) {return;}
+
+	//Trails; One instanced line strip per individual ship, read straight from the history ring. [See trails.cpp]
+	trails::RingState ring = trails::state();
+	GLuint trailLength = std::min(ring.filled, trails::length());
+	if ((ring.shipCount > 0u) && (trailLength >= 2u)) {
+		glUseProgram(GLIndex::trailShader);
+		uniforms::bindUniformValue(GLIndex::trailShader, "head", ring.head);
+		uniforms::bindUniformValue(GLIndex::trailShader, "capacity", ring.capacity);
+		uniforms::bindUniformValue(GLIndex::trailShader, "shipCount", ring.shipCount);
+		uniforms::bindUniformValue(GLIndex::trailShader, "trailLength", trailLength);
+		uniforms::bindUniformValue(GLIndex::trailShader, "fade", trails::fade());
+		glBindVertexArray(GLIndex::genericVAO);
+		profiler::countStateChanges(2u); //Program, VAO.
+		for (size_t index=0; index<viewports::count(); index++) {
+			const clusters::ViewMarkers& markers = clusters::get(index);
+			if (markers.shipCount == 0) {continue;}
+			viewports::bind(index);
+			glDrawArraysInstancedBaseInstance(GL_LINE_STRIP, 0, trailLength, markers.shipCount, markers.base);
+			profiler::countDraws();
+		}
+		utils::GLErrorcheck("trailShader", true);
+	}
+
+	//Markers; Ships, then clusters weighted by their count.
+	glUseProgram(GLIndex::shipMarkerShader);
+	glBindVertexArray(GLIndex::genericVAO);
+	profiler::countStateChanges(2u); //Program, VAO.
+	for (size_t index=0; index<viewports::count(); index++) {
+		const clusters::ViewMarkers& markers = clusters::get(index);
+		if (markers.markerCount == 0) {continue;}
+		viewports::bind(index);
+		glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, markers.markerCount, markers.base);
+		profiler::countDraws();
+	}
+	viewports::unbind();
+	glBindVertexArray(0);
+	glUseProgram(0);
+	utils::GLErrorcheck("shipMarkerShader", true);
 }
 
 
 
-}
\ No newline at end of file
+
+#define BOARD_LINE_HEIGHT (9 * display::LABEL_SCALE) //As text.cpp spaces lines; Glyph height + 2.
+
+static void boardLabels(size_t viewIndex, const viewports::Viewport& viewport, const structs::CameraView& view) {
+	//The focus body's arrivals & departures, one label per line down the view's top left. [See schedule.cpp]
+	const structs::CelestialBody& focus = *view.focusBody;
+	const schedule::Board& board = schedule::board(static_cast<size_t>(&focus - data::bodies.data()));
+	glm::ivec2 topLeft = viewport.origin + glm::ivec2(0, viewport.size.y) + glm::ivec2(display::VIEWPORT_CULL_MARGIN, -display::VIEWPORT_CULL_MARGIN) - display::LABEL_OFFSET;
+	uint64_t line = 0u;
+	auto add = [&](const std::string& text, glm::vec3 colour) {
+		text::add((uint64_t(3u) << 48u) | (uint64_t(viewIndex) << 32u) | line, {text}, topLeft - glm::ivec2(0, static_cast<int>(line) * BOARD_LINE_HEIGHT), colour, 0u);
+		line++;
+	};
+	auto row = [](const schedule::Row& row, const char* direction) {
+		const structs::SpaceCraft& ship = data::spacecraft[row.ship];
+		return ship.name + " " + ship.route->number + " " + direction + " " + data::bodies[row.body].name + " " + schedule::formatTime(row.time);
+	};
+
+	add(focus.name + " ARRIVALS", glm::vec3(1.0f, 0.85f, 0.25f));
+	for (const schedule::Row& arrival : board.arrivals) {add(row(arrival, "FROM"), glm::vec3(0.9f));}
+	add(focus.name + " DEPARTURES", glm::vec3(1.0f, 0.85f, 0.25f));
+	for (const schedule::Row& departure : board.departures) {add(row(departure, "TO"), glm::vec3(0.9f));}
+}
+
+
+void labels() {
+	//Names of every body, ship & ship cluster in every view (and the focus' board), decluttered and drawn in one instanced call. [See text.cpp]
+	text::begin();
+	for (size_t viewIndex=0; viewIndex<viewports::count(); viewIndex++) {
+		const viewports::Viewport& viewport = viewports::get(viewIndex);
+		const structs::CameraView& view = viewports::view(viewIndex);
+		glm::ivec2 focus = view.focusBody->position;
+		glm::ivec2 centre = viewport.origin + view.offset + (viewport.size / 2);
+		auto toScreen = [&](glm::ivec2 position) {return glm::ivec2(glm::vec2(position - focus) * view.scale) + centre;}; //As in the shaders.
+		if (viewports::count() > 1u) {text::area(viewport.origin, viewport.size);}
+		if (schedule::visible()) {boardLabels(viewIndex, viewport, view); /* Before the rest, so it wins any overlap. */}
+
+		for (size_t index=0; index<data::bodies.size(); index++) {
+			const structs::CelestialBody& body = data::bodies[index];
+			unsigned int priority = (&body == view.focusBody) ? 0u : 2u + static_cast<unsigned int>(body.type); //Focus, ships, stars, planets, satellites.
+			text::add(index, {body.name}, toScreen(body.position), glm::mix(body.colour, glm::vec3(1.0f), 0.5f), priority);
+		}
+
+		//Ships drawn individually are named, clusters show their count. [See clusters.cpp]
+		const clusters::ViewMarkers& markers = clusters::get(viewIndex);
+		const clusters::Marker* marker = clusters::markers(viewIndex);
+		for (GLsizei index=0; index<markers.markerCount; index++) {
+			glm::ivec2 anchor = viewport.origin + marker[index].position;
+			if (index < markers.shipCount) {
+				const structs::SpaceCraft& ship = data::spacecraft[marker[index].ship];
+				text::add((uint64_t(1u) << 32u) | marker[index].ship, {ship.name, ship.journey.number}, anchor, glm::vec3(0.25f, 0.85f, 1.0f), 1u);
+			} else {
+				uint64_t cell = (uint64_t(marker[index].position.y) << 16u) | uint64_t(marker[index].position.x); //Cell centre, unique in the view.
+				text::add((uint64_t(2u) << 48u) | (uint64_t(viewIndex) << 32u) | cell, {std::to_string(marker[index].count) + " ships"}, anchor, glm::vec3(0.25f, 0.85f, 1.0f), 1u);
+			}
+		}
+	}
+
+	GLsizei glyphCount = text::build();
+	if (glyphCount == 0) {return;}
+	glUseProgram(GLIndex::textShader);
+	uniforms::bindUniformValue(GLIndex::textShader, "projectionMatrix", GLIndex::projectionMatrix);
+	uniforms::bindUniformValue(GLIndex::textShader, "glyphScale", display::LABEL_SCALE);
+	uniforms::bindUniformValue(GLIndex::textShader, "glyphAtlas", 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, GLIndex::glyphAtlas);
+	glBindVertexArray(GLIndex::genericVAO);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, glyphCount);
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+	profiler::countDraws();
+	profiler::countStateChanges(3u); //Program, texture, VAO.
+	utils::GLErrorcheck("textShader", true);
+}
+
+
+
+
+}
@@ -36,11 +36,11 @@ namespace graphics {
 
 
 	GLuint createShaderStorageBufferObject(int binding, size_t bufferSize=0, GLuint glType=GL_DYNAMIC_DRAW);
-	//Different types for GPU and CPU (padding, unecessary data removed.)
+	//Different types for GPU and CPU (padding, unecessary data removed.) One-off uploads, see streaming.h for per-frame data.
 	template<typename TGPU, typename TCPU>  void updateShaderStorageBufferObject(GLuint SSBO, std::vector<TCPU>* dataSetIn, int allocSize);
 	//Overload of the above without the size specified.
 	template<typename TGPU, typename TCPU>  void updateShaderStorageBufferObject(GLuint SSBO, std::vector<TCPU>* dataSetIn);
-	//Same type for CPU & GPU.
+	//Same type for CPU & GPU. One-off uploads too.
 	template<typename T> 					void updateShaderStorageBufferObject(GLuint SSBO, T* data, size_t count);
 
 
@@ -65,7 +65,6 @@ namespace graphics {
 
 
 	//// ATOMIC ////
-	GLuint zero = 0u;
 	void fetchAndClearAtomic(GLuint atomicCounter, GLuint* counterValue);
 	GLuint createAtomicCounter(unsigned int binding);
 	//// ATOMIC ////
@@ -97,7 +96,9 @@ namespace frame {
 	inline void renderingGeneric(const std::string& shaderName="");
 
 	void bodies(); //Draw the "background", of the Stars/Planets/Moons/Satellites.
+	void heatmap(); //Ship traffic density around the --heatmap body, when shown.
 	void spacecraft(); //Draw the "notable" objects, the spacecraft flying around.
+	void labels(); //Names of the bodies & spacecraft, over everything else.
 
 }
 
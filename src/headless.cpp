@@ -0,0 +1,264 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "glutils.h"
+#include "graphics.h"
+#include "physics.h"
+#include "ephemeris.h"
+#include "capture.h"
+#include "trails.h"
+#include "profiler.h"
+#include "viewports.h"
+#include "clusters.h"
+#include "headless.h"
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Headless mode renders into an FBO on a surfaceless EGL context, so no window system
+(X11/Wayland) is needed. Works with Mesa's llvmpipe, which only exposes 4.5 by default;
+  LIBGL_ALWAYS_SOFTWARE=1 MESA_GL_VERSION_OVERRIDE=4.6 MESA_GLSL_VERSION_OVERRIDE=460 ./app --headless
+\* -------------------------------------------------------------------------------- */
+
+
+#ifdef __linux__
+static EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+static EGLContext eglContext = EGL_NO_CONTEXT;
+#endif
+
+
+enum BenchmarkPass {
+	BP_EVALUATE,   //ephemeris::evaluate(), spacecraft::evaluate(), trails::record(), viewports::prepare() & clusters::update()
+	BP_BODIES,     //frame::bodies()
+	BP_SPACECRAFT, //frame::spacecraft() & frame::labels()
+	BP_COUNT
+};
+static const char* passNames[BP_COUNT] = {"evaluate", "bodies", "spacecraft"};
+
+
+struct PassStats {
+	double cpuSum = 0.0d, cpuMin = constants::INF, cpuMax = 0.0d; //Milliseconds.
+	double gpuSum = 0.0d, gpuMin = constants::INF, gpuMax = 0.0d; //Milliseconds.
+
+	void addCPU(double ms) {cpuSum += ms; cpuMin = std::min(cpuMin, ms); cpuMax = std::max(cpuMax, ms);}
+	void addGPU(double ms) {gpuSum += ms; gpuMin = std::min(gpuMin, ms); gpuMax = std::max(gpuMax, ms);}
+};
+
+
+static inline double msSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+
+
+namespace headless {
+
+void initialiseContext() {
+#ifdef __linux__
+	//Prefer the surfaceless platform, it needs no display server at all.
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	if (getPlatformDisplay) {eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);}
+	if (eglDisplay == EGL_NO_DISPLAY) {eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);}
+
+	EGLint eglMajor, eglMinor;
+	if ((eglDisplay == EGL_NO_DISPLAY) || !eglInitialize(eglDisplay, &eglMajor, &eglMinor)) {
+		utils::raise("Failed to initialise EGL.");
+		return;
+	}
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		utils::raise("EGL does not support desktop OpenGL.");
+		return;
+	}
+
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, display::OPENGL_VERSION_MAJOR,
+		EGL_CONTEXT_MINOR_VERSION, display::OPENGL_VERSION_MINOR,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	eglContext = eglCreateContext(eglDisplay, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+	if (eglContext == EGL_NO_CONTEXT) {
+		utils::raise("Failed to create an OpenGL " + std::to_string(display::OPENGL_VERSION_MAJOR) + "." + std::to_string(display::OPENGL_VERSION_MINOR) + " context. (llvmpipe: set MESA_GL_VERSION_OVERRIDE=4.6 MESA_GLSL_VERSION_OVERRIDE=460)");
+		return;
+	}
+	if (!eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext)) {
+		utils::raise("Failed to make the surfaceless context current.");
+		return;
+	}
+
+	glewExperimental = GL_TRUE;
+	GLenum glewStatus = glewInit();
+	if ((glewStatus != GLEW_OK) && (glewStatus != GLEW_ERROR_NO_GLX_DISPLAY)) { //No GLX display is expected, GL itself loaded fine.
+		utils::raise("Failed to initialize GLEW.");
+	}
+
+	std::cout << "Headless context: EGL " << eglMajor << "." << eglMinor << " | " << glGetString(GL_RENDERER) << " | " << glGetString(GL_VERSION) << std::endl;
+#else
+	utils::raise("Headless mode is only supported on Linux.");
+#endif
+}
+
+
+void destroyContext() {
+#ifdef __linux__
+	if (eglDisplay == EGL_NO_DISPLAY) {return;}
+	eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (eglContext != EGL_NO_CONTEXT) {eglDestroyContext(eglDisplay, eglContext);}
+	eglTerminate(eglDisplay);
+	eglDisplay = EGL_NO_DISPLAY;
+	eglContext = EGL_NO_CONTEXT;
+#endif
+}
+
+
+
+void runBenchmark(std::vector<structs::BenchmarkStep>& steps) {
+	GLuint colourTexture;
+	GLuint FBO = graphics::createAFBO(glm::uvec2(currentRenderResolution), colourTexture);
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glViewport(0, 0, currentRenderResolution.x, currentRenderResolution.y);
+	glEnable(GL_BLEND);
+
+	std::filesystem::path dirName = std::filesystem::path("saved.benchmarks");
+	std::filesystem::create_directories(dirName);
+	std::filesystem::path csvPath = dirName / (utils::getTimestampStr() + ".csv");
+	std::ofstream csv(csvPath);
+	csv << "step,view,pass,frames,cpu_mean_ms,cpu_min_ms,cpu_max_ms,gpu_mean_ms,gpu_min_ms,gpu_max_ms" << std::endl;
+
+	std::cout << "Benchmark: " << steps.size() << " steps at " << currentRenderResolution.x << "x" << currentRenderResolution.y << " | Ephemeris on the " << ((ephemeris::usingGPU()) ? "GPU" : "CPU") << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+
+
+	for (size_t stepIndex=0; stepIndex<steps.size(); stepIndex++) {
+		structs::BenchmarkStep& step = steps[stepIndex];
+		data::view = step.view;
+		data::currentCameraViewIndex = static_cast<unsigned int>(step.view - data::views.data());
+
+		//One timer query per pass per measured frame, only read back once the step is done.
+		std::vector<GLuint> queries(step.frames * BP_COUNT);
+		glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+		std::array<PassStats, BP_COUNT> stats;
+		PassStats frameStats;
+
+		auto stepStart = std::chrono::steady_clock::now();
+		for (unsigned int frame=0u; frame<(step.warmup + step.frames); frame++) {
+			bool measured = (frame >= step.warmup);
+			unsigned int measuredFrame = frame - step.warmup;
+			if (frame == step.warmup) {glFinish(); stepStart = std::chrono::steady_clock::now(); /* Start measuring from an idle GPU. */}
+			time_t UTC = step.time + (step.timeStep * static_cast<time_t>(frame));
+			auto frameStart = std::chrono::steady_clock::now();
+
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			for (unsigned int pass=0u; pass<BP_COUNT; pass++) {
+				if (measured) {glBeginQuery(GL_TIME_ELAPSED, queries[(measuredFrame * BP_COUNT) + pass]);}
+				auto passStart = std::chrono::steady_clock::now();
+
+				switch (pass) {
+					case BP_EVALUATE:   {ephemeris::evaluate(UTC); spacecraft::evaluate(UTC); trails::record(UTC); viewports::prepare(); clusters::update(); break;}
+					case BP_BODIES:     {frame::bodies(); break;}
+					case BP_SPACECRAFT: {frame::spacecraft(); frame::labels(); break;}
+				}
+
+				if (measured) {
+					stats[pass].addCPU(msSince(passStart));
+					glEndQuery(GL_TIME_ELAPSED);
+				}
+			}
+			glFlush(); //Stands in for the swap.
+			if (measured) {frameStats.addCPU(msSince(frameStart));}
+			profiler::endFrame(msSince(frameStart)); //CPU scopes only, the passes already hold GL_TIME_ELAPSED queries.
+		}
+		glFinish();
+		double stepMs = msSince(stepStart);
+
+
+		//Collect GPU times.
+		for (unsigned int frame=0u; frame<step.frames; frame++) {
+			double frameGPU = 0.0d;
+			for (unsigned int pass=0u; pass<BP_COUNT; pass++) {
+				GLuint64 elapsed = 0u;
+				glGetQueryObjectui64v(queries[(frame * BP_COUNT) + pass], GL_QUERY_RESULT, &elapsed);
+				double ms = static_cast<double>(elapsed) * 1.0e-6d;
+				stats[pass].addGPU(ms);
+				frameGPU += ms;
+			}
+			frameStats.addGPU(frameGPU);
+		}
+		glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+
+
+		//Report.
+		double n = static_cast<double>(step.frames);
+		std::cout << "Step " << stepIndex << " \"" << step.view->name << "\" : " << step.frames << " frames, " << (stepMs / n) << "ms/frame wall (" << static_cast<int>(n / (stepMs * 1.0e-3d)) << "Hz)" << std::endl;
+		for (unsigned int pass=0u; pass<=BP_COUNT; pass++) {
+			PassStats& s = (pass == BP_COUNT) ? frameStats : stats[pass];
+			const char* name = (pass == BP_COUNT) ? "frame" : passNames[pass];
+			std::cout << "  " << std::setw(10) << name
+				<< " | CPU mean " << (s.cpuSum / n) << " min " << s.cpuMin << " max " << s.cpuMax
+				<< " | GPU mean " << (s.gpuSum / n) << " min " << s.gpuMin << " max " << s.gpuMax << std::endl;
+			csv << stepIndex << ",\"" << step.view->name << "\"," << name << "," << step.frames << ","
+				<< (s.cpuSum / n) << "," << s.cpuMin << "," << s.cpuMax << ","
+				<< (s.gpuSum / n) << "," << s.gpuMin << "," << s.gpuMax << std::endl;
+		}
+	}
+
+	std::cout << std::defaultfloat << "Benchmark results saved as : [" << csvPath << "]" << std::endl;
+	utils::GLErrorcheck("Benchmark", false);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &FBO);
+	glDeleteTextures(1, &colourTexture);
+}
+
+
+
+
+void runRecording(unsigned int frames, time_t startTime, time_t timeStep, recorder::RecordingFormat format) {
+	GLuint colourTexture;
+	GLuint FBO = graphics::createAFBO(glm::uvec2(currentRenderResolution), colourTexture);
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glViewport(0, 0, currentRenderResolution.x, currentRenderResolution.y);
+	glEnable(GL_BLEND);
+
+	if (!recorder::start(currentRenderResolution, startTime, timeStep, format)) {
+		utils::raise("Failed to start recording.");
+		return;
+	}
+
+	auto recordingStart = std::chrono::steady_clock::now();
+	for (unsigned int frame=0u; frame<frames; frame++) {
+		time_t UTC = recorder::frameTime();
+		auto frameStart = std::chrono::steady_clock::now();
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		ephemeris::evaluate(UTC);
+		spacecraft::evaluate(UTC);
+		trails::record(UTC);
+		viewports::prepare();
+		clusters::update();
+		frame::bodies();
+		frame::spacecraft();
+		frame::labels();
+
+		recorder::captureFrame(FBO, currentRenderResolution);
+		capture::poll();
+		profiler::endFrame(msSince(frameStart));
+		if ((frame % 600u) == 599u) {std::cout << "Recorded " << (frame + 1u) << "/" << frames << " frames." << std::endl;}
+	}
+	recorder::stop();
+
+	double seconds = msSince(recordingStart) * 1.0e-3d;
+	std::cout << frames << " frames in " << seconds << "s (" << (static_cast<double>(frames) / seconds) << " frames/s)" << std::endl;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &FBO);
+	glDeleteTextures(1, &colourTexture);
+}
+
+}
@@ -0,0 +1,26 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "includes.h"
+#include "global.h"
+#include "recorder.h"
+
+
+
+
+namespace headless {
+
+	//Offscreen OpenGL context without a window (EGL, surfaceless). Linux only.
+	void initialiseContext();
+	void destroyContext();
+
+	//Render every step into an FBO, then report per-pass CPU & GPU frame times.
+	void runBenchmark(std::vector<structs::BenchmarkStep>& steps);
+
+	//Render a time-lapse of the current view into an FBO. [See recorder.cpp]
+	void runRecording(unsigned int frames, time_t startTime, time_t timeStep, recorder::RecordingFormat format);
+
+}
+
+
+#endif
@@ -0,0 +1,265 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "glutils.h"
+#include "threading.h"
+#include "profiler.h"
+#include "heatmap.h"
+#include <stb_image_write.h>
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Traffic density heatmaps; Every ship position, every tick, accumulated around one body.
+ - Multi-resolution; sim::HEATMAP_LEVELS nested square grids centred on the body, each
+   sim::HEATMAP_LEVEL_SCALE times wider. A position is binned into the finest level that
+   holds it, so close traffic keeps its detail and distant traffic is still counted.
+ - Binning is split over a private worker pool, each chunk of ships into its own partial
+   grids; No atomics or locks, and the partials are only read once the pool has finished.
+ - Every sim::HEATMAP_REDUCE_TICKS the partials are folded into the 64 bit totals and
+   cleared. Each level is then completed with the levels inside it (summed 4x4 into its
+   centre), converted to density and published through a TripleBuffer.
+ - The render thread uploads it to a texture array, drawn under the ships per view, and
+   can export every level side by side as a PNG.
+\* -------------------------------------------------------------------------------- */
+
+
+static_assert(std::has_single_bit(static_cast<uint64_t>(sim::HEATMAP_EXTENT)) && std::has_single_bit(static_cast<unsigned int>(sim::HEATMAP_LEVEL_SCALE)) && std::has_single_bit(static_cast<unsigned int>(sim::HEATMAP_RESOLUTION)), "Cells are found by shifting; Powers of 2 only.");
+static_assert(sim::HEATMAP_RESOLUTION % (2 * sim::HEATMAP_LEVEL_SCALE) == 0, "Each level must sit on whole cells of the next.");
+
+constexpr size_t LEVEL_CELLS = static_cast<size_t>(sim::HEATMAP_RESOLUTION) * sim::HEATMAP_RESOLUTION;
+constexpr size_t GRID_CELLS = LEVEL_CELLS * sim::HEATMAP_LEVELS;
+constexpr int EXTENT_SHIFT = std::countr_zero(static_cast<uint64_t>(sim::HEATMAP_EXTENT));
+constexpr unsigned int LEVEL_BITS = std::countr_zero(static_cast<unsigned int>(sim::HEATMAP_LEVEL_SCALE)); //Levels found from the bit width of the distance, without a search.
+
+//Per chunk of ships; Written by one job at a time.
+struct Partial {
+	std::vector<uint32_t> counts; //GRID_CELLS, at most HEATMAP_REDUCE_TICKS * ships per cell.
+	unsigned long long samples = 0u, outside = 0u;
+};
+
+static std::atomic<bool> accumulating = false;
+static int centreBody = -1;
+static std::unique_ptr<threading::WorkerPool> pool;
+static std::vector<Partial> partials;
+static std::vector<uint64_t> totals; //GRID_CELLS; Only the positions binned into each level, not the ones inside it.
+static unsigned long long tickCount = 0u, sampleCount = 0u, outsideCount = 0u;
+static std::array<int64_t, sim::HEATMAP_LEVELS> halfWidths;
+static std::array<int, sim::HEATMAP_LEVELS> cellShifts; //log2 of each level's cell width.
+static threading::TripleBuffer<heatmap::Density> published;
+
+//Render thread;
+static GLuint densityTexture = 0u;
+static bool shown = true, uploaded = false;
+static unsigned int exportSequence = 0u;
+
+
+
+static void bin(Partial& partial, const glm::ivec2* positions, size_t count, glm::ivec2 centre) {
+	//Finest level whose square holds the position, then its cell by shifting. Same mapping as heatmap.frag.
+	uint32_t* counts = partial.counts.data();
+	unsigned long long outside = 0u;
+	for (size_t index=0; index<count; index++) {
+		int64_t x = static_cast<int64_t>(positions[index].x) - centre.x;
+		int64_t y = static_cast<int64_t>(positions[index].y) - centre.y;
+		uint64_t reach = static_cast<uint64_t>(std::max(std::abs(x), std::abs(y))) >> EXTENT_SHIFT; //In finest half widths.
+		unsigned int level = (static_cast<unsigned int>(std::bit_width(reach)) + LEVEL_BITS - 1u) / LEVEL_BITS;
+		if (level >= sim::HEATMAP_LEVELS) {outside++; continue;}
+		size_t column = static_cast<size_t>((x + halfWidths[level]) >> cellShifts[level]);
+		size_t row = static_cast<size_t>((y + halfWidths[level]) >> cellShifts[level]);
+		counts[(level * LEVEL_CELLS) + (row * sim::HEATMAP_RESOLUTION) + column]++;
+	}
+	partial.samples += count;
+	partial.outside += outside;
+}
+
+
+static void reduce() {
+	//Simulation thread, with the pool idle.
+	PROFILE_SCOPE("heatmap::reduce");
+	for (Partial& partial : partials) {
+		for (size_t cell=0; cell<GRID_CELLS; cell++) {totals[cell] += partial.counts[cell];}
+		std::fill(partial.counts.begin(), partial.counts.end(), 0u);
+		sampleCount += partial.samples;
+		outsideCount += partial.outside;
+		partial.samples = 0u;
+		partial.outside = 0u;
+	}
+
+	//Complete each level with the (already complete) level inside it, summed into its centre cells.
+	static std::vector<uint64_t> complete(GRID_CELLS);
+	constexpr int scale = sim::HEATMAP_LEVEL_SCALE, resolution = sim::HEATMAP_RESOLUTION;
+	constexpr int inner = resolution / scale, corner = (resolution - inner) / 2;
+	std::copy(totals.begin(), totals.begin() + LEVEL_CELLS, complete.begin());
+	for (size_t level=1u; level<sim::HEATMAP_LEVELS; level++) {
+		uint64_t* coarse = complete.data() + (level * LEVEL_CELLS);
+		const uint64_t* fine = complete.data() + ((level - 1u) * LEVEL_CELLS);
+		std::copy(totals.begin() + (level * LEVEL_CELLS), totals.begin() + ((level + 1u) * LEVEL_CELLS), coarse);
+		for (int row=0; row<resolution; row++) {
+			for (int column=0; column<resolution; column++) {
+				coarse[((corner + (row / scale)) * resolution) + corner + (column / scale)] += fine[(row * resolution) + column];
+			}
+		}
+	}
+
+	heatmap::Density& density = published.back();
+	density.body = centreBody;
+	density.ticks = tickCount;
+	density.samples = sampleCount;
+	density.outside = outsideCount;
+	density.density.resize(GRID_CELLS);
+	float maxDensity = 0.0f, area = 1.0f;
+	for (size_t level=0u; level<sim::HEATMAP_LEVELS; level++) {
+		//Per finest cell's area, so every level shares one scale.
+		for (size_t cell=level*LEVEL_CELLS; cell<(level + 1u)*LEVEL_CELLS; cell++) {
+			density.density[cell] = static_cast<float>(complete[cell]) / area;
+			maxDensity = std::max(maxDensity, density.density[cell]);
+		}
+		area *= static_cast<float>(scale * scale);
+	}
+	density.maxDensity = maxDensity;
+	published.publish();
+}
+
+
+
+
+namespace heatmap {
+
+bool start(const std::string& bodyName) {
+	centreBody = -1;
+	for (size_t index=0; index<data::bodies.size(); index++) {
+		if (utils::strToLower(data::bodies[index].name) == utils::strToLower(bodyName)) {centreBody = static_cast<int>(index); break;}
+	}
+	if (centreBody < 0) {
+		std::cerr << "No body named \"" << bodyName << "\", no heatmap." << std::endl;
+		return false;
+	}
+
+	int64_t halfWidth = sim::HEATMAP_EXTENT;
+	for (size_t level=0u; level<sim::HEATMAP_LEVELS; level++) {
+		halfWidths[level] = halfWidth;
+		cellShifts[level] = std::countr_zero(static_cast<uint64_t>(halfWidth * 2 / sim::HEATMAP_RESOLUTION));
+		halfWidth *= sim::HEATMAP_LEVEL_SCALE;
+	}
+
+	pool = std::make_unique<threading::WorkerPool>();
+	partials.assign(std::max(pool->size(), 1u), Partial{});
+	for (Partial& partial : partials) {partial.counts.assign(GRID_CELLS, 0u);}
+	totals.assign(GRID_CELLS, 0u);
+	tickCount = sampleCount = outsideCount = 0u;
+	accumulating = true;
+	std::cout << "Accumulating a traffic heatmap around " << data::bodies[centreBody].name << ", [H] toggles it, [F6] exports it." << std::endl;
+	return true;
+}
+
+
+bool active() {
+	return accumulating;
+}
+
+
+void accumulate(const std::vector<glm::ivec2>& bodyPositions, const std::vector<glm::ivec2>& shipPositions) {
+	if (!accumulating) {return;}
+	PROFILE_SCOPE("heatmap::accumulate");
+	glm::ivec2 centre = bodyPositions[centreBody];
+	size_t count = shipPositions.size();
+	if (count < sim::HEATMAP_PARALLEL_MIN) {
+		bin(partials[0], shipPositions.data(), count, centre); //Not worth waking the pool.
+	} else {
+		size_t chunk = (count + partials.size() - 1u) / partials.size();
+		for (size_t index=0; index<partials.size(); index++) {
+			size_t begin = std::min(index * chunk, count), end = std::min(begin + chunk, count);
+			pool->submit([index, begin, end, centre, &shipPositions]() {bin(partials[index], shipPositions.data() + begin, end - begin, centre);});
+		}
+		pool->wait();
+	}
+	if (++tickCount % sim::HEATMAP_REDUCE_TICKS == 0u) {reduce();}
+}
+
+
+void stop() {
+	accumulating = false;
+	pool.reset();
+}
+
+
+
+bool update() {
+	if (!accumulating || !published.acquire()) {return false;}
+	PROFILE_SCOPE("heatmap::update");
+	if (densityTexture == 0u) {
+		glGenTextures(1, &densityTexture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, densityTexture);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_R32F, sim::HEATMAP_RESOLUTION, sim::HEATMAP_RESOLUTION, sim::HEATMAP_LEVELS);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	} else {
+		glBindTexture(GL_TEXTURE_2D_ARRAY, densityTexture);
+	}
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, sim::HEATMAP_RESOLUTION, sim::HEATMAP_RESOLUTION, sim::HEATMAP_LEVELS, GL_RED, GL_FLOAT, published.front().density.data());
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	uploaded = true;
+	utils::GLErrorcheck("heatmap::update", true);
+	return true;
+}
+
+
+bool visible() {
+	return accumulating && shown && uploaded;
+}
+
+void toggle() {
+	shown = !shown;
+	std::cout << "Heatmap overlay " << ((shown) ? "shown" : "hidden") << "." << std::endl;
+}
+
+GLuint texture() {
+	return densityTexture;
+}
+
+const Density& current() {
+	return published.front();
+}
+
+
+glm::vec3 heat(float value) {
+	//Black body; Red, through yellow, to white.
+	return glm::clamp(glm::vec3(value * 3.0f, (value * 3.0f) - 1.0f, (value * 3.0f) - 2.0f), glm::vec3(0.0f), glm::vec3(1.0f));
+}
+
+
+void exportImage() {
+	if (!uploaded) {std::cout << "Nothing accumulated to export yet." << std::endl; return;}
+	const Density& density = current();
+	std::filesystem::path dirName = std::filesystem::path("saved.heatmaps");
+	std::filesystem::create_directories(dirName);
+	std::ostringstream name;
+	name << utils::getTimestampStrPrecise() << "_" << data::bodies[density.body].name << "_" << (exportSequence++ % 10000u) << ".png";
+	std::filesystem::path imagePath = dirName / name.str();
+
+	//Encoded on a worker, from a copy; The front slot is replaced on the next update().
+	threading::workers().submit([imagePath, values = density.density, maxDensity = density.maxDensity, samples = density.samples, outside = density.outside]() {
+		//Levels left to right, finest first, with north up.
+		constexpr size_t resolution = sim::HEATMAP_RESOLUTION, width = resolution * sim::HEATMAP_LEVELS;
+		std::vector<unsigned char> rgb(width * resolution * 3u, 0u);
+		float logMax = std::log1p(std::max(maxDensity, 1.0e-6f));
+		for (size_t level=0u; level<sim::HEATMAP_LEVELS; level++) {
+			for (size_t row=0u; row<resolution; row++) {
+				for (size_t column=0u; column<resolution; column++) {
+					float value = values[(level * LEVEL_CELLS) + (row * resolution) + column];
+					if (value <= 0.0f) {continue;}
+					glm::vec3 colour = heatmap::heat(std::log1p(value) / logMax);
+					unsigned char* pixel = rgb.data() + ((((resolution - 1u - row) * width) + (level * resolution) + column) * 3u);
+					for (int channel=0; channel<3; channel++) {pixel[channel] = static_cast<unsigned char>(colour[channel] * 255.0f);}
+				}
+			}
+		}
+		stbi_write_png(imagePath.string().c_str(), static_cast<int>(width), static_cast<int>(resolution), 3, rgb.data(), static_cast<int>(width * 3u));
+		std::cout << "Saved heatmap (" << samples << " positions, " << outside << " beyond it) as : [" << imagePath << "]" << std::endl;
+	});
+}
+
+}
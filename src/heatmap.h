@@ -0,0 +1,43 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include "includes.h"
+#include "constants.h"
+#include "global.h"
+
+
+
+
+namespace heatmap {
+
+	//The reduced grids, as published to the render thread. "density" in heatmap.frag (GL_TEXTURE_2D_ARRAY, one layer per level).
+	struct Density {
+		int body = -1;						//Index in data::bodies the grids are centred on.
+		unsigned long long ticks = 0u;		//Ticks accumulated.
+		unsigned long long samples = 0u;	//Ship positions binned.
+		unsigned long long outside = 0u;	//Of those, beyond the coarsest level.
+		float maxDensity = 0.0f;			//Densest cell, on any level.
+		std::vector<float> density;			//[level][row][column], ships per finest cell's area. Each level includes the levels inside it.
+	};
+
+
+	//Simulation thread;
+	bool start(const std::string& bodyName); //Call before simulation::start(). False if there is no such body.
+	bool active();
+	void accumulate(const std::vector<glm::ivec2>& bodyPositions, const std::vector<glm::ivec2>& shipPositions); //Every tick, from the filled snapshot.
+	void stop(); //After simulation::stop().
+
+	//Render thread;
+	bool update(); //Uploads the newest reduced grids, when there are some. True if they changed.
+	bool visible(); //Active, shown, and something has been published.
+	void toggle(); //[H]
+	GLuint texture();
+	const Density& current(); //As last uploaded.
+	void exportImage(); //[F6] Every level side by side, to "saved.heatmaps/".
+
+	glm::vec3 heat(float value); //Colour ramp, 0 to 1. As in heatmap.frag.
+
+}
+
+
+#endif
@@ -0,0 +1,447 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "profiler.h"
+#include "journal.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Journal file (.sbj), memory-mapped;
+ - One page of header, then records back to back. header.committed is only moved past
+   a record once it is complete, so a crash never leaves a torn record to replay.
+ - Every sim::JOURNAL_KEYFRAME_INTERVAL ticks; 'K', int64 UTC, int32 x, y per ship.
+ - Every other tick; 'T', zigzag varint UTC change, then per ship the zigzag varint
+   change in its velocity (delta of delta), x then y. Ships under constant or slowly
+   changing acceleration cost 2 bytes each.
+Index file (.sbi); One entry per keyframe, {int64 UTC, uint64 offset, uint64 tick}.
+Seeking binary searches the index, then decodes forward at most one keyframe interval.
+A missing or short index is rebuilt by scanning the journal.
+The writer maps a large range once (sim::JOURNAL_RESERVE) and grows the file under it in
+sim::JOURNAL_GROWTH steps, so recording never remaps or copies. Linux only.
+\* -------------------------------------------------------------------------------- */
+
+
+struct JournalHeader {
+	char magic[4] = {'S', 'B', 'J', 'R'};
+	uint32_t version = 1u;
+	uint32_t shipCount = 0u, bodyCount = 0u;
+	std::atomic<uint64_t> committed = 0u; //Record bytes after the header page.
+	std::atomic<uint64_t> ticks = 0u;
+	int64_t firstUTC = 0, lastUTC = 0;
+};
+constexpr size_t HEADER_PAGE = 4096u;
+
+struct IndexEntry {
+	int64_t UTC;
+	uint64_t offset; //Of the keyframe, from the start of the records.
+	uint64_t tick;
+};
+
+struct Cursor {
+	const unsigned char* records = nullptr;
+	uint64_t offset = 0u, end = 0u;
+	uint64_t tick = 0u;
+	time_t UTC = 0;
+	std::vector<glm::ivec2> positions, velocities; //Per tick.
+};
+
+
+//Recording; Simulation thread only.
+static int writeFile = -1;
+static unsigned char* writeMap = nullptr;
+static JournalHeader* writeHeader = nullptr;
+static uint64_t writeSize = 0u; //File size.
+static std::FILE* indexFile = nullptr;
+static std::filesystem::path journalPath;
+static std::vector<glm::ivec2> lastPositions, lastVelocities;
+static time_t lastUTC = 0;
+static uint64_t ticksSinceKeyframe = 0u;
+
+//Replay;
+static int readFile = -1;
+static const unsigned char* readMap = nullptr;
+static size_t readSize = 0u;
+static std::vector<IndexEntry> keyframes;
+static Cursor cursor;
+static std::atomic<bool> replayActive = false;
+static std::atomic<int64_t> seekTarget = std::numeric_limits<int64_t>::min(); //Pending seek, if not min().
+static std::atomic<int64_t> replayUTC = 0;
+static std::chrono::steady_clock::time_point replayClock;
+static time_t replayClockUTC = 0;
+static bool reportedEnd = false;
+
+
+
+//// ENCODING ////
+static inline uint64_t zigzag(int64_t value) {return (static_cast<uint64_t>(value) << 1u) ^ static_cast<uint64_t>(value >> 63);}
+static inline int64_t unzigzag(uint64_t value) {return static_cast<int64_t>(value >> 1u) ^ -static_cast<int64_t>(value & 1u);}
+
+static inline unsigned char* putVarint(unsigned char* out, uint64_t value) {
+	while (value >= 0x80u) {*out++ = static_cast<unsigned char>(value | 0x80u); value >>= 7u;}
+	*out++ = static_cast<unsigned char>(value);
+	return out;
+}
+
+static inline bool getVarint(const unsigned char* records, uint64_t& offset, uint64_t end, uint64_t& value) {
+	value = 0u;
+	for (unsigned int shift=0u; (offset < end) && (shift < 64u); shift+=7u) {
+		unsigned char byte = records[offset++];
+		value |= static_cast<uint64_t>(byte & 0x7Fu) << shift;
+		if (!(byte & 0x80u)) {return true;}
+	}
+	return false;
+}
+
+
+static bool peekUTC(const Cursor& at, time_t& UTC) {
+	//UTC of the next record, without decoding it.
+	if (at.offset >= at.end) {return false;}
+	uint64_t offset = at.offset + 1u;
+	if (at.records[at.offset] == 'K') {
+		if (offset + sizeof(int64_t) > at.end) {return false;}
+		int64_t keyUTC;
+		std::memcpy(&keyUTC, at.records + offset, sizeof(keyUTC));
+		UTC = static_cast<time_t>(keyUTC);
+		return true;
+	}
+	uint64_t change;
+	if (!getVarint(at.records, offset, at.end, change)) {return false;}
+	UTC = at.UTC + static_cast<time_t>(unzigzag(change));
+	return true;
+}
+
+
+static bool step(Cursor& at) {
+	//Decode the next record. False at the end (or a record for another ship count).
+	if (at.offset >= at.end) {return false;}
+	unsigned char tag = at.records[at.offset++];
+	size_t shipCount = at.positions.size();
+	if (tag == 'K') {
+		if (at.offset + sizeof(int64_t) + (shipCount * 8u) > at.end) {return false;}
+		int64_t keyUTC;
+		std::memcpy(&keyUTC, at.records + at.offset, sizeof(keyUTC));
+		at.offset += sizeof(keyUTC);
+		at.UTC = static_cast<time_t>(keyUTC);
+		std::memcpy(at.positions.data(), at.records + at.offset, shipCount * 8u);
+		at.offset += shipCount * 8u;
+		std::fill(at.velocities.begin(), at.velocities.end(), glm::ivec2(0, 0));
+	} else if (tag == 'T') {
+		uint64_t value;
+		if (!getVarint(at.records, at.offset, at.end, value)) {return false;}
+		at.UTC += static_cast<time_t>(unzigzag(value));
+		for (size_t ship=0; ship<shipCount; ship++) {
+			uint64_t x, y;
+			if (!getVarint(at.records, at.offset, at.end, x) || !getVarint(at.records, at.offset, at.end, y)) {return false;}
+			at.velocities[ship] += glm::ivec2(static_cast<int>(unzigzag(x)), static_cast<int>(unzigzag(y)));
+			at.positions[ship] += at.velocities[ship];
+		}
+	} else {
+		return false; //Corrupt.
+	}
+	at.tick++;
+	return true;
+}
+//// ENCODING ////
+
+
+
+#ifdef __linux__
+static bool ensureCapacity(uint64_t bytes) {
+	//Grow the file under the existing mapping. False if the reserved range or the disk is full.
+	//Allocated, not just sized; A store to a sparse page with no disk behind it would be SIGBUS, not an error.
+	uint64_t needed = HEADER_PAGE + writeHeader->committed.load(std::memory_order_relaxed) + bytes;
+	if (needed <= writeSize) {return true;}
+	if (needed > sim::JOURNAL_RESERVE) {return false;}
+	uint64_t size = std::min<uint64_t>(((needed / sim::JOURNAL_GROWTH) + 1u) * sim::JOURNAL_GROWTH, sim::JOURNAL_RESERVE);
+	if (::posix_fallocate(writeFile, static_cast<off_t>(writeSize), static_cast<off_t>(size - writeSize)) != 0) {return false;}
+	writeSize = size;
+	return true;
+}
+
+
+static void loadIndex(const std::filesystem::path& indexPath, const JournalHeader& header) {
+	keyframes.clear();
+	std::ifstream file(indexPath, std::ios::binary);
+	IndexEntry entry;
+	while (file.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+		if (entry.offset >= header.committed) {break; /* Written after the journal's last commit. */}
+		keyframes.push_back(entry);
+	}
+
+	//Rebuild from the last entry read to the end, if the index is short (or missing).
+	Cursor scan;
+	scan.records = readMap + HEADER_PAGE;
+	scan.end = header.committed;
+	scan.positions.resize(header.shipCount);
+	scan.velocities.resize(header.shipCount);
+	if (!keyframes.empty()) {scan.offset = keyframes.back().offset; scan.tick = keyframes.back().tick;}
+	size_t rebuilt = 0u;
+	bool first = true;
+	while (scan.offset < scan.end) {
+		uint64_t offset = scan.offset;
+		uint64_t tick = scan.tick;
+		bool keyframe = (scan.records[offset] == 'K');
+		if (!step(scan)) {break;}
+		if (keyframe && !(first && !keyframes.empty())) {keyframes.push_back({static_cast<int64_t>(scan.UTC), offset, tick}); rebuilt++;}
+		first = false;
+	}
+	if (rebuilt > 0u) {std::cout << "Journal index was short, " << rebuilt << " keyframes re-indexed." << std::endl;}
+}
+
+
+static void seekTo(time_t UTC) {
+	//Last tick at or before UTC.
+	auto after = std::upper_bound(keyframes.begin(), keyframes.end(), static_cast<int64_t>(UTC), [](int64_t target, const IndexEntry& entry) {return target < entry.UTC;});
+	const IndexEntry& keyframe = (after == keyframes.begin()) ? keyframes.front() : *std::prev(after);
+	cursor.offset = keyframe.offset;
+	cursor.tick = keyframe.tick;
+	step(cursor);
+
+	time_t next;
+	while (peekUTC(cursor, next) && (next <= UTC)) {
+		if (!step(cursor)) {break;}
+	}
+	replayClock = std::chrono::steady_clock::now();
+	replayClockUTC = std::max(UTC, cursor.UTC);
+	replayUTC = replayClockUTC;
+	reportedEnd = false;
+}
+#endif
+
+
+
+
+namespace journal {
+
+bool startRecording(size_t shipCount, size_t bodyCount) {
+#ifdef __linux__
+	if (writeMap) {return false; /* Already recording. */}
+	std::filesystem::path dirName = std::filesystem::path("saved.journals");
+	std::filesystem::create_directories(dirName);
+	std::string stem = utils::getTimestampStrPrecise();
+	journalPath = dirName / (stem + ".sbj");
+
+	writeFile = ::open(journalPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (writeFile < 0) {
+		std::cerr << "Could not create journal [" << journalPath << "] : " << std::strerror(errno) << std::endl;
+		return false;
+	}
+	void* mapped = ::mmap(nullptr, sim::JOURNAL_RESERVE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, writeFile, 0);
+	if (mapped == MAP_FAILED) {
+		std::cerr << "Could not map journal [" << journalPath << "] : " << std::strerror(errno) << std::endl;
+		::close(writeFile);
+		return false;
+	}
+	int allocated = ::posix_fallocate(writeFile, 0, sim::JOURNAL_GROWTH); //Returns the error, rather than setting errno.
+	if (allocated != 0) {
+		std::cerr << "Could not size journal [" << journalPath << "] : " << std::strerror(allocated) << std::endl;
+		::munmap(mapped, sim::JOURNAL_RESERVE);
+		::close(writeFile);
+		return false;
+	}
+	writeMap = static_cast<unsigned char*>(mapped);
+	writeSize = sim::JOURNAL_GROWTH;
+	writeHeader = new (writeMap) JournalHeader();
+	writeHeader->shipCount = static_cast<uint32_t>(shipCount);
+	writeHeader->bodyCount = static_cast<uint32_t>(bodyCount);
+
+	indexFile = std::fopen((dirName / (stem + ".sbi")).c_str(), "wb");
+	lastPositions.assign(shipCount, glm::ivec2(0, 0));
+	lastVelocities.assign(shipCount, glm::ivec2(0, 0));
+	ticksSinceKeyframe = 0u;
+	std::cout << "Recording journal to [" << journalPath << "]" << std::endl;
+	return true;
+#else
+	std::cerr << "Journals are only supported on Linux." << std::endl;
+	return false;
+#endif
+}
+
+
+void record(time_t UTC, const std::vector<structs::SpaceCraft>& ships) {
+#ifdef __linux__
+	if (!writeMap || (ships.size() != lastPositions.size())) {return;}
+	PROFILE_SCOPE("journal::record");
+	bool keyframe = (ticksSinceKeyframe == 0u);
+	if (!ensureCapacity(1u + 10u + (ships.size() * ((keyframe) ? 8u : 10u)))) {
+		std::cerr << "Journal is full (or the disk is), recording stopped." << std::endl;
+		stopRecording();
+		return;
+	}
+
+	uint64_t offset = writeHeader->committed.load(std::memory_order_relaxed);
+	unsigned char* start = writeMap + HEADER_PAGE + offset;
+	unsigned char* out = start;
+	if (keyframe) {
+		*out++ = 'K';
+		int64_t keyUTC = static_cast<int64_t>(UTC);
+		std::memcpy(out, &keyUTC, sizeof(keyUTC));
+		out += sizeof(keyUTC);
+		for (size_t ship=0; ship<ships.size(); ship++) {
+			std::memcpy(out, &ships[ship].position, 8u);
+			out += 8u;
+			lastPositions[ship] = ships[ship].position;
+			lastVelocities[ship] = glm::ivec2(0, 0);
+		}
+	} else {
+		*out++ = 'T';
+		out = putVarint(out, zigzag(static_cast<int64_t>(UTC - lastUTC)));
+		for (size_t ship=0; ship<ships.size(); ship++) {
+			glm::ivec2 velocity = ships[ship].position - lastPositions[ship];
+			glm::ivec2 change = velocity - lastVelocities[ship];
+			out = putVarint(out, zigzag(change.x));
+			out = putVarint(out, zigzag(change.y));
+			lastPositions[ship] = ships[ship].position;
+			lastVelocities[ship] = velocity;
+		}
+	}
+
+	if (writeHeader->ticks == 0u) {writeHeader->firstUTC = UTC;}
+	writeHeader->lastUTC = UTC;
+	writeHeader->ticks.fetch_add(1u, std::memory_order_relaxed);
+	writeHeader->committed.store(offset + static_cast<uint64_t>(out - start), std::memory_order_release); //Record complete.
+	if (keyframe && indexFile) {
+		IndexEntry entry = {static_cast<int64_t>(UTC), offset, writeHeader->ticks - 1u};
+		std::fwrite(&entry, sizeof(entry), 1u, indexFile);
+		std::fflush(indexFile); //Once per keyframe interval.
+	}
+	lastUTC = UTC;
+	ticksSinceKeyframe = (ticksSinceKeyframe + 1u) % sim::JOURNAL_KEYFRAME_INTERVAL;
+#endif
+}
+
+
+void stopRecording() {
+#ifdef __linux__
+	if (!writeMap) {return;}
+	uint64_t committed = writeHeader->committed, ticks = writeHeader->ticks;
+	::msync(writeMap, HEADER_PAGE + committed, MS_ASYNC);
+	::munmap(writeMap, sim::JOURNAL_RESERVE);
+	if (::ftruncate(writeFile, static_cast<off_t>(HEADER_PAGE + committed)) != 0) {/* Only unused space left at the end. */}
+	::close(writeFile);
+	if (indexFile) {std::fclose(indexFile);}
+	writeMap = nullptr;
+	writeHeader = nullptr;
+	indexFile = nullptr;
+	std::cout << "Journal stopped : " << ticks << " ticks, " << (HEADER_PAGE + committed) << " bytes saved as : [" << journalPath << "]" << std::endl;
+#endif
+}
+
+
+
+bool startReplay(const std::string& path, time_t startUTC) {
+#ifdef __linux__
+	readFile = ::open(path.c_str(), O_RDONLY);
+	struct stat info;
+	if ((readFile < 0) || (::fstat(readFile, &info) != 0) || (static_cast<size_t>(info.st_size) < HEADER_PAGE)) {
+		std::cerr << "Could not open journal [" << path << "]" << std::endl;
+		if (readFile >= 0) {::close(readFile);}
+		return false;
+	}
+	readSize = static_cast<size_t>(info.st_size);
+	void* mapped = ::mmap(nullptr, readSize, PROT_READ, MAP_SHARED, readFile, 0);
+	if (mapped == MAP_FAILED) {::close(readFile); return false;}
+	readMap = static_cast<const unsigned char*>(mapped);
+	::madvise(mapped, readSize, MADV_RANDOM); //Seeks jump around, only the pages decoded are read.
+
+	const JournalHeader& header = *reinterpret_cast<const JournalHeader*>(readMap);
+	JournalHeader expected;
+	if (
+		(std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) || (header.version != expected.version) ||
+		(HEADER_PAGE + header.committed > readSize) || (header.ticks == 0u)
+	) {
+		std::cerr << "Journal [" << path << "] is empty, or not a journal." << std::endl;
+		stopReplay();
+		return false;
+	}
+	if (header.shipCount != data::spacecraft.size()) {
+		std::cout << "Journal has " << header.shipCount << " ships, the data file " << data::spacecraft.size() << ". Extra ships keep their planned positions." << std::endl;
+	}
+
+	cursor = Cursor();
+	cursor.records = readMap + HEADER_PAGE;
+	cursor.end = header.committed;
+	cursor.positions.resize(header.shipCount);
+	cursor.velocities.resize(header.shipCount);
+	loadIndex(std::filesystem::path(path).replace_extension(".sbi"), header);
+	if (keyframes.empty()) {stopReplay(); return false;}
+
+	seekTo((startUTC == 0) ? static_cast<time_t>(header.firstUTC) : startUTC);
+	replayActive = true;
+	std::cout << "Replaying journal [" << path << "] : " << header.ticks << " ticks, UTC " << header.firstUTC << " to " << header.lastUTC << "." << std::endl;
+	return true;
+#else
+	std::cerr << "Journals are only supported on Linux." << std::endl;
+	return false;
+#endif
+}
+
+
+bool replaying() {
+	return replayActive;
+}
+
+
+void seek(time_t UTC) {
+	seekTarget = static_cast<int64_t>(UTC);
+}
+
+void seekBy(time_t seconds) {
+	seekTarget = replayUTC + static_cast<int64_t>(seconds);
+}
+
+
+time_t replayTime() {
+#ifdef __linux__
+	int64_t target = seekTarget.exchange(std::numeric_limits<int64_t>::min());
+	if (target != std::numeric_limits<int64_t>::min()) {
+		PROFILE_SCOPE("journal::seek");
+		seekTo(static_cast<time_t>(target));
+	}
+	//Scaled time, at the same rate as utils::getTimestamp().
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayClock).count();
+	replayUTC = replayClockUTC + static_cast<time_t>(seconds * sim::DEBUG_TIME_SCALING * simSpeed);
+#endif
+	return static_cast<time_t>(replayUTC.load());
+}
+
+
+void replay(std::vector<structs::SpaceCraft>& ships) {
+#ifdef __linux__
+	PROFILE_SCOPE("journal::replay");
+	time_t next;
+	time_t UTC = static_cast<time_t>(replayUTC.load());
+	while (peekUTC(cursor, next) && (next <= UTC)) {
+		if (!step(cursor)) {break;}
+	}
+	if ((cursor.offset >= cursor.end) && !reportedEnd) {
+		std::cout << "Replay reached the end of the journal, holding the last tick." << std::endl;
+		reportedEnd = true;
+	}
+	size_t count = std::min(ships.size(), cursor.positions.size());
+	for (size_t ship=0; ship<count; ship++) {ships[ship].position = cursor.positions[ship];}
+#endif
+}
+
+
+void stopReplay() {
+#ifdef __linux__
+	replayActive = false;
+	if (readMap) {::munmap(const_cast<unsigned char*>(readMap), readSize);}
+	if (readFile >= 0) {::close(readFile);}
+	readMap = nullptr;
+	readFile = -1;
+	keyframes.clear();
+#endif
+}
+
+}
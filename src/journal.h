@@ -0,0 +1,31 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "includes.h"
+#include "constants.h"
+#include "global.h"
+
+
+
+
+namespace journal {
+
+	//Recording; Appends every simulation tick to "saved.journals/<timestamp>.sbj", with a time index beside it (.sbi).
+	//Bodies are closed-form in UTC, so only the UTC & ship positions (with any telemetry/broadcast corrections) are kept.
+	bool startRecording(size_t shipCount, size_t bodyCount);
+	void record(time_t UTC, const std::vector<structs::SpaceCraft>& ships); //Simulation thread, every tick.
+	void stopRecording();
+
+	//Replay; Plays a journal back in real (scaled) time, in place of evaluating the ships.
+	bool startReplay(const std::string& path, time_t startUTC=0); //0 starts from the beginning.
+	bool replaying();
+	void seek(time_t UTC); //Any thread, takes effect on the next tick.
+	void seekBy(time_t seconds); //Relative to the current replay time.
+	time_t replayTime(); //Simulation thread; Advances the replay clock, returns the UTC to evaluate bodies at.
+	void replay(std::vector<structs::SpaceCraft>& ships); //Simulation thread; Ship positions at the last replayTime().
+	void stopReplay();
+
+}
+
+
+#endif
@@ -0,0 +1,99 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "glutils.h"
+#include "graphics.h"
+#include "profiler.h"
+#include "viewports.h"
+#include "layers.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Cached static layers; Content that is fixed for a given camera (e.g. orbit rings
+centred on the focus) is drawn once into a texture, then composited every frame.
+ - Each view's part of the layer is keyed on its focus, scale, offset, rectangle and
+   instance count, and only redrawn (scissored to the view) when that key changes.
+ - A new render target size recreates the layer and redraws every view.
+ - Composited with one textured quad, so a still view costs one full screen blend
+   instead of every line in it. Anything moving is drawn over it as usual.
+\* -------------------------------------------------------------------------------- */
+
+
+static const GLfloat transparent[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+
+
+
+namespace layers {
+
+size_t refresh(Layer& layer, const std::vector<ViewKey>& keys, void (*draw)(size_t viewIndex)) {
+	PROFILE_SCOPE("layers::refresh");
+	glm::ivec4 target = viewports::area();
+	glm::ivec2 size = glm::max(glm::ivec2(target.z, target.w), glm::ivec2(1, 1));
+
+	GLint previous = 0, previousRead = 0; //Restored after; The window, or the headless target.
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+	bool bound = false;
+	auto bindLayer = [&]() {
+		if (bound) {return;}
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, layer.FBO);
+		profiler::countStateChanges(1u); //Framebuffer.
+		bound = true;
+	};
+
+	if ((layer.FBO == 0u) || (layer.size != size) || (layer.keys.size() != keys.size())) {
+		//Resized, or views added/removed; Start from an empty layer.
+		if (layer.size != size) {
+			if (layer.FBO != 0u) {glDeleteFramebuffers(1, &layer.FBO); glDeleteTextures(1, &layer.texture);}
+			layer.FBO = graphics::createAFBO(glm::uvec2(size), layer.texture);
+			layer.size = size;
+		}
+		bindLayer();
+		glClearBufferfv(GL_COLOR, 0, transparent);
+		layer.keys.assign(keys.size(), ViewKey{});
+	}
+
+	size_t redrawn = 0u;
+	for (size_t index=0; index<keys.size(); index++) {
+		if (keys[index] == layer.keys[index]) {continue; /* Still valid. */}
+		bindLayer();
+		glm::ivec4 pixels = viewports::rectangle(index);
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(pixels.x, pixels.y, pixels.z, pixels.w);
+		glClearBufferfv(GL_COLOR, 0, transparent);
+		glDisable(GL_SCISSOR_TEST);
+		if (keys[index].count > 0) {draw(index);}
+		layer.keys[index] = keys[index];
+		redrawn++;
+	}
+
+	if (bound) {
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(previous));
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previousRead)); //createAFBO() unbinds both.
+		viewports::unbind();
+		profiler::countStateChanges(1u); //Framebuffer.
+		utils::GLErrorcheck("layers::refresh", true);
+	}
+	return redrawn;
+}
+
+
+void composite(const Layer& layer) {
+	if (layer.FBO == 0u) {return;}
+	glUseProgram(GLIndex::layerShader);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, layer.texture);
+	glBindVertexArray(GLIndex::genericVAO);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4); //Over viewports::area(), the current GL viewport.
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+	profiler::countDraws();
+	profiler::countStateChanges(3u); //Program, texture, VAO.
+}
+
+}
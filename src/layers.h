@@ -0,0 +1,40 @@
+#ifndef LAYERS_H
+#define LAYERS_H
+
+#include "includes.h"
+#include "constants.h"
+#include "global.h"
+
+
+
+
+namespace layers {
+
+	//What a view's part of a layer was last drawn with; Redrawn when any of it differs.
+	struct ViewKey {
+		const structs::CelestialBody* focus = nullptr;
+		float scale = 0.0f;
+		glm::ivec2 offset = glm::ivec2(0, 0);
+		glm::ivec4 rectangle = glm::ivec4(0); //viewports::rectangle()
+		GLsizei count = 0; //Instances drawn.
+
+		bool operator==(const ViewKey&) const = default;
+	};
+
+	//Content that only changes with its view, cached in a render target sized texture.
+	struct Layer {
+		GLuint FBO = 0u, texture = 0u;
+		glm::ivec2 size = glm::ivec2(0, 0);
+		std::vector<ViewKey> keys; //Per view.
+	};
+
+
+	//Redraws each view whose key (One per viewports::count()) changed, calling draw(viewIndex) with the layer bound.
+	//Call after viewports::prepare(). Returns the number of views redrawn.
+	size_t refresh(Layer& layer, const std::vector<ViewKey>& keys, void (*draw)(size_t viewIndex));
+	void composite(const Layer& layer); //Blended over the render target, beneath whatever is drawn next.
+
+}
+
+
+#endif
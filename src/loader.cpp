@@ -1,7 +1,8 @@
-#include "includes.h"
-#include "global.h"
+#include "coreincludes.h"
+#include "structs.h"
 #include "utils.h"
 #include "physics.h"
+#include "profiler.h"
 using namespace std;
 using namespace glm;
 
@@ -44,6 +45,14 @@ static inline int getInt(const pugi::xml_node& node, std::string attrName, int d
 	return defaultValue;
 }
 
+static inline long long getInt64(const pugi::xml_node& node, std::string attrName, long long defaultValue=0) {
+	pugi::xml_attribute attr = node.attribute(attrName.c_str());
+	if (attr) {
+		return attr.as_llong();
+	}
+	return defaultValue;
+}
+
 static inline float getFloat(const pugi::xml_node& node, std::string attrName, float defaultValue=0.0f) {
 	pugi::xml_attribute attr = node.attribute(attrName.c_str());
 	if (attr) {
@@ -119,7 +128,9 @@ static inline std::vector<std::string> getStringList(const pugi::xml_node& node,
 
 void getBodies(const pugi::xml_document& doc) {
 	//Gets all celestial bodies (Including unnatural satellites too.)
-	data::bodies.reserve(constants::NUMBER_OF_BODIES_TO_RESERVE); //Reserve space in the bodies dataset.
+	//Reserve space in the bodies dataset. Parent/child pointers are taken while loading, so it must never reallocate.
+	size_t bodyCount = doc.select_nodes("//bodies/star | //bodies/star/planet | //bodies/star/planet/satellite").size();
+	data::bodies.reserve(std::max(bodyCount, constants::NUMBER_OF_BODIES_TO_RESERVE));
 	pugi::xpath_node_set starNodes = doc.select_nodes("//bodies/star");
 
 
@@ -359,26 +370,65 @@ void getAngles(const pugi::xml_document& doc) {
 
 
 
+//////// BENCHMARK ////////
+
+structs::CameraView* getView(const std::string& name) {
+	//Find the first view with the same name (Case sensitive).
+	for (structs::CameraView& view : data::views) {
+		if (view.name == name) {return &view;}
+	}
+	return nullptr;
+}
+
+std::vector<structs::BenchmarkStep> getDefaultBenchmark(unsigned int warmup) {
+	//Every view at the current time, if no script was given.
+	std::vector<structs::BenchmarkStep> steps;
+	for (structs::CameraView& view : data::views) {
+		steps.push_back(structs::BenchmarkStep(&view, utils::getTimestamp(), 0, 120u, warmup));
+	}
+	return steps;
+}
+
+//////// BENCHMARK ////////
+
+
+
+
+
 namespace loader {
 
+structs::CelestialBody* findBody(const std::string& name) {
+	structs::CelestialBody* body = nullptr;
+	getFocussedBody(name, &body);
+	return body;
+}
+
+
 void loadXMLdata(std::string& xmlFilePath) {
 	pugi::xml_document doc;
-	pugi::xml_parse_result parseResult = doc.load_file(xmlFilePath.c_str());
+	pugi::xml_parse_result parseResult;
+	{PROFILE_SCOPE("loader::parse"); parseResult = doc.load_file(xmlFilePath.c_str());}
 
 	if (!parseResult) {
 		throw std::runtime_error("Failed to parse XML: " + std::string(parseResult.description()));
 	}
 
 
-	getBodies(doc);
-	getRoutes(doc);
-	getSShips(doc);
-	getAngles(doc);
+	{PROFILE_SCOPE("loader::getBodies"); getBodies(doc);}
+	{PROFILE_SCOPE("loader::getRoutes"); getRoutes(doc);}
+	{PROFILE_SCOPE("loader::getSShips"); getSShips(doc);}
+	{PROFILE_SCOPE("loader::getAngles"); getAngles(doc);}
 
+	//Defaults first; A reload without <meta> must not keep the previous file's values.
+	simSpeed = 1u;
+	data::trailLength = display::TRAIL_LENGTH;
+	data::trailFade = display::TRAIL_FADE;
 	auto n = doc.select_nodes("//meta");
 	if (n.size() > 0u) {
 		pugi::xml_node metaNode = n[0].node();
 		simSpeed = static_cast<unsigned int>(abs(xml::getInt(metaNode, "simSpeed", 1)));
+		data::trailLength = static_cast<unsigned int>(abs(xml::getInt(metaNode, "trailLength", display::TRAIL_LENGTH)));
+		data::trailFade = xml::getFloat(metaNode, "trailFade", display::TRAIL_FADE);
 	}
 
 
@@ -387,4 +437,44 @@ void loadXMLdata(std::string& xmlFilePath) {
 	spacecraft::evaluate();
 }
 
+
+
+std::vector<structs::BenchmarkStep> loadBenchmarkScript(const std::string& scriptPath) {
+	//Must be called after loadXMLdata(), views are referenced by name.
+	pugi::xml_document doc;
+	pugi::xml_parse_result parseResult = doc.load_file(scriptPath.c_str());
+	if (!parseResult) {
+		std::cout << "No benchmark script at [" << scriptPath << "], using every camera view instead." << std::endl;
+		return getDefaultBenchmark(10u);
+	}
+
+	pugi::xpath_node_set rootNodes = doc.select_nodes("//benchmark");
+	unsigned int warmup = (rootNodes.size() > 0u) ? xml::getInt(rootNodes[0].node(), "warmup", 10) : 10u;
+
+	std::vector<structs::BenchmarkStep> steps;
+	pugi::xpath_node_set stepNodes = doc.select_nodes("//benchmark/step");
+	for (unsigned int stepIndex=0u; stepIndex<stepNodes.size(); stepIndex++) {
+		pugi::xml_node stepNode = stepNodes[stepIndex].node();
+		std::string viewName = xml::getString(stepNode, "view", "");
+		structs::CameraView* view = getView(viewName);
+		if (!view) {
+			std::cout << "Benchmark step " << stepIndex << " skipped, no view named \"" << viewName << "\"." << std::endl;
+			continue;
+		}
+		steps.push_back(structs::BenchmarkStep(
+			view,
+			static_cast<time_t>(xml::getInt64(stepNode, "time", utils::getTimestamp())),
+			static_cast<time_t>(xml::getInt64(stepNode, "timeStep", 0)),
+			static_cast<unsigned int>(std::max(xml::getInt(stepNode, "frames", 120), 1)),
+			static_cast<unsigned int>(std::max(xml::getInt(stepNode, "warmup", warmup), 0))
+		));
+	}
+
+	if (steps.empty()) {
+		std::cout << "Benchmark script [" << scriptPath << "] has no valid steps, using every camera view instead." << std::endl;
+		return getDefaultBenchmark(warmup);
+	}
+	return steps;
+}
+
 }
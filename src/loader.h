@@ -1,12 +1,15 @@
 #ifndef LOADER_H
 #define LOADER_H
 
-#include "includes.h"
+#include "coreincludes.h"
 #include "constants.h"
+#include "structs.h"
 
 
 namespace loader {
 	void loadXMLdata(std::string& xmlFilePath);
+	std::vector<structs::BenchmarkStep> loadBenchmarkScript(const std::string& scriptPath);
+	structs::CelestialBody* findBody(const std::string& name); //First body with this name (Case sensitive), or nullptr.
 }
 
 
@@ -0,0 +1,96 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "pacer.h"
+#ifndef __WIN32
+#include <time.h>
+#endif
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+The old limiter spun on std::this_thread::yield(), which keeps a whole core busy.
+Instead, sleep on an absolute deadline (clock_nanosleep, TIMER_ABSTIME), waking
+display::PACER_SPIN_US early, then spin only for that last fraction of a millisecond.
+Windows falls back to std::this_thread::sleep_until with the same spin.
+\* -------------------------------------------------------------------------------- */
+
+
+typedef std::chrono::steady_clock Clock; //CLOCK_MONOTONIC on Linux.
+
+static double targetRate = display::HZ;
+static Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0d / display::HZ));
+static Clock::time_point deadline;
+static bool started = false;
+
+static double lateness = 0.0d, latenessTotal = 0.0d;
+static unsigned long long frames = 0u, missed = 0u;
+
+
+
+static void sleepUntil(Clock::time_point wake) {
+#ifndef __WIN32
+	long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wake.time_since_epoch()).count();
+	struct timespec target = {static_cast<time_t>(ns / 1000000000ll), static_cast<long>(ns % 1000000000ll)};
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, nullptr) == EINTR) {} //Signals; Sleep the rest.
+#else
+	std::this_thread::sleep_until(wake);
+#endif
+}
+
+
+
+
+namespace pacer {
+
+void setRate(double hz) {
+	targetRate = hz;
+	if (hz > 0.0d) {period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0d / hz));}
+	started = false; //Next wait() starts a fresh schedule.
+}
+
+double rate() {
+	return targetRate;
+}
+
+
+void wait() {
+	if (targetRate <= 0.0d) {return; /* Unlimited. */}
+	Clock::time_point now = Clock::now();
+	if (!started) {deadline = now; started = true;}
+
+	deadline += period;
+	if (now > deadline) {
+		//Overran a whole period; Start again from now, rather than rush the next frames.
+		missed++;
+		deadline = now;
+		lateness = 0.0d;
+		return;
+	}
+
+	Clock::time_point wake = deadline - std::chrono::microseconds(display::PACER_SPIN_US);
+	if (now < wake) {sleepUntil(wake);}
+	while ((now = Clock::now()) < deadline) {} //Sub-millisecond spin.
+
+	lateness = std::chrono::duration<double, std::micro>(now - deadline).count();
+	latenessTotal += lateness;
+	frames++;
+}
+
+
+
+double lastLateness() {
+	return lateness;
+}
+
+double drift() {
+	return (frames == 0u) ? 0.0d : (latenessTotal / static_cast<double>(frames));
+}
+
+unsigned long long missedFrames() {
+	return missed;
+}
+
+}
@@ -0,0 +1,29 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include "includes.h"
+#include "constants.h"
+
+
+
+
+namespace pacer {
+
+	//Frame limiter for when VSync is off. Sleeps until just before each deadline, then spins for the rest.
+	//Deadlines are absolute (previous deadline + period), so sleep overshoot never accumulates as drift.
+	//Jitter; Within ~display::PACER_SPIN_US of the deadline as long as the OS wakes the thread
+	//before the spin window starts (typically 50-100us late on an idle Linux host). A frame that
+	//overruns a whole period resynchronises, rather than rushing frames to catch up.
+
+	void setRate(double hz); //Frames per second, at runtime. <= 0 disables pacing.
+	double rate();
+	void wait(); //Call once per frame, at the end.
+
+	double lastLateness(); //Microseconds after the deadline the last wait() returned.
+	double drift(); //Mean lateness so far, in microseconds.
+	unsigned long long missedFrames(); //Frames which overran their whole period.
+
+}
+
+
+#endif
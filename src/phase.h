@@ -0,0 +1,100 @@
+#ifndef PHASE_H
+#define PHASE_H
+
+#include "coreincludes.h"
+#include "constants.h"
+#include <bit>
+
+
+//Fixed point orbital phase; Integer only from the period to the position, so every machine,
+//compiler & the compute shader (ephemeris.comp) agree to the bit, -ffast-math or not.
+// - A phase is a 32 bit fraction of a turn, wrapping at 2^32.
+// - Each orbit has a Q32.32 step, in turns per sim second. Its phase at UTC is the top half
+//   of one wrapping 64 bit multiply, exact however large UTC gets.
+// - Sine & cosine come from a Q1.30 table of 2^sim::SINE_TABLE_BITS steps per turn (built
+//   at compile time), linearly interpolated on the rest of the phase.
+
+
+namespace phase {
+
+	constexpr unsigned int TABLE_SIZE = 1u << sim::SINE_TABLE_BITS;
+	constexpr unsigned int FRACTION_BITS = 32u - sim::SINE_TABLE_BITS; //Of the phase, between table entries.
+	constexpr int ONE_SHIFT = 30; //Q1.30
+	constexpr double TURN = 6.283185307179586476925d; //Radians; In double, unlike constants::PI2.
+	constexpr unsigned int PERIOD_FRACTION_BITS = std::countr_zero(static_cast<unsigned int>(1.0f / sim::TIME_PRECISION)); //Periods are rounded to sim::TIME_PRECISION.
+
+
+	constexpr double taylorSine(double x) {
+		//|x| <= PI/4; The terms left out are below 1e-19.
+		double term = x, sum = x;
+		for (int n=1; n<10; n++) {term *= -(x * x) / static_cast<double>((2 * n) * ((2 * n) + 1)); sum += term;}
+		return sum;
+	}
+
+	constexpr double taylorCosine(double x) {
+		double term = 1.0d, sum = 1.0d;
+		for (int n=1; n<10; n++) {term *= -(x * x) / static_cast<double>(((2 * n) - 1) * (2 * n)); sum += term;}
+		return sum;
+	}
+
+	constexpr std::array<int32_t, TABLE_SIZE + 1u> makeSineTable() {
+		//One entry past the turn, so interpolation never wraps. No libm; The compiler's constant evaluation is exact IEEE.
+		std::array<int32_t, TABLE_SIZE + 1u> table = {};
+		constexpr unsigned int quarter = TABLE_SIZE / 4u;
+		for (unsigned int index=0; index<=TABLE_SIZE; index++) {
+			unsigned int offset = index % quarter, quadrant = (index / quarter) % 4u;
+			double angle = (static_cast<double>(offset) / static_cast<double>(TABLE_SIZE)) * TURN;
+			double complement = (static_cast<double>(quarter - offset) / static_cast<double>(TABLE_SIZE)) * TURN;
+			double sine = (offset * 2u <= quarter) ? taylorSine(angle) : taylorCosine(complement); //Within the first quadrant, from whichever series is nearer 0.
+			double cosine = (offset * 2u <= quarter) ? taylorCosine(angle) : taylorSine(complement);
+			double value = (quadrant == 0u) ? sine : (quadrant == 1u) ? cosine : (quadrant == 2u) ? -sine : -cosine;
+			double scaled = value * static_cast<double>(1 << ONE_SHIFT);
+			table[index] = static_cast<int32_t>((scaled < 0.0d) ? (scaled - 0.5d) : (scaled + 0.5d));
+		}
+		return table;
+	}
+
+	inline constexpr std::array<int32_t, TABLE_SIZE + 1u> sineTable = makeSineTable();
+	static_assert((sineTable[0] == 0) && (sineTable[TABLE_SIZE / 4u] == (1 << ONE_SHIFT)) && (sineTable[TABLE_SIZE / 2u] == 0) && (sineTable[TABLE_SIZE] == 0), "Sine table is off.");
+
+
+	inline uint64_t step(float period) {
+		//2^64 turns over the period (in sim seconds), by long division of 2^(64 + PERIOD_FRACTION_BITS) by the period in sim::TIME_PRECISION units.
+		//Rounded to nearest. Periods under a second are clamped, as their step would not fit.
+		uint64_t divisor = static_cast<uint64_t>(std::llround(static_cast<double>(period) * static_cast<double>(1u << PERIOD_FRACTION_BITS)));
+		divisor = std::max(divisor, (uint64_t(1u) << PERIOD_FRACTION_BITS) + 1u);
+		uint64_t quotient = 0u, remainder = 0u;
+		for (int bit=64+static_cast<int>(PERIOD_FRACTION_BITS); bit>=0; bit--) {
+			remainder = (remainder << 1u) | ((bit == 64 + static_cast<int>(PERIOD_FRACTION_BITS)) ? 1u : 0u);
+			quotient <<= 1u;
+			if (remainder >= divisor) {remainder -= divisor; quotient |= 1u;}
+		}
+		return quotient + (((remainder * 2u) >= divisor) ? 1u : 0u);
+	}
+
+	inline uint32_t at(uint64_t step, time_t UTC) {
+		//Wraps; Only the fraction of a turn is kept.
+		return static_cast<uint32_t>((step * static_cast<uint64_t>(UTC)) >> 32u);
+	}
+
+	inline int32_t sine(uint32_t phase) {
+		//Q1.30
+		uint32_t index = phase >> FRACTION_BITS;
+		int64_t fraction = static_cast<int64_t>(phase & ((1u << FRACTION_BITS) - 1u));
+		int32_t low = sineTable[index], high = sineTable[index + 1u];
+		return low + static_cast<int32_t>((static_cast<int64_t>(high - low) * fraction) >> FRACTION_BITS);
+	}
+
+	inline int32_t cosine(uint32_t phase) {
+		return sine(phase + (1u << 30u)); //A quarter turn on.
+	}
+
+	inline int32_t scale(int32_t radius, int32_t value) {
+		//radius * Q1.30, rounded down.
+		return static_cast<int32_t>((static_cast<int64_t>(radius) * value) >> ONE_SHIFT);
+	}
+
+}
+
+
+#endif
@@ -1,6 +1,9 @@
-#include "includes.h"
-#include "global.h"
+#include "coreincludes.h"
+#include "structs.h"
 #include "utils.h"
+#include "physics.h"
+#include "phase.h"
+#include "profiler.h"
 using namespace std;
 using namespace glm;
 
@@ -9,20 +12,18 @@ using namespace glm;
 /* -------------------------------------------------------------------------------- *\
 UTC uses current time to calculate vessel/body positions.
 Assumes the default state listed in the data file is the state when UTC value was "0".
-Everything operates in real-time, Very deterministic.
+Everything operates in real-time, Very deterministic. Body positions use fixed point
+phases & a sine table, so are the same on every machine & on the GPU. [See phase.h]
 \* -------------------------------------------------------------------------------- */
 
 
 void calculateBody(time_t UTC, structs::CelestialBody* parentBody, structs::CelestialBody* thisBody) {
 	//Calculate position around its parent via the current time in UTC.
-	//TBA
-	glm::vec2 centreOfRotation = parentBody->position;
-	double days = static_cast<double>(
-		UTC % static_cast<unsigned int>(ceil(thisBody->orbitalPeriod/sim::TIME_PRECISION))
-	);
-	double a = (days / thisBody->orbitalPeriod) * 2.0f * constants::PI;
-	glm::vec2 offset = glm::vec2(cos(a), sin(a)) * thisBody->orbitalRadius;
-	thisBody->position = centreOfRotation + offset;
+	//Integer only, bit-identical everywhere; The phase is one wrapping multiply, sine & cosine from the table. [See phase.h]
+	uint32_t angle = phase::at(thisBody->phaseStep, UTC);
+	int32_t radius = static_cast<int32_t>(thisBody->orbitalRadius);
+	glm::ivec2 offset = glm::ivec2(phase::scale(radius, phase::cosine(angle)), phase::scale(radius, phase::sine(angle)));
+	thisBody->position = parentBody->position + offset;
 	if (dev::DEBUG_BODY_LOCATIONS) {std::cout << thisBody->name << " : (" << thisBody->position.x << ", " << thisBody->position.y << ")" << std::endl;}
 
 	for (structs::CelestialBody* child : thisBody->children) {
@@ -37,8 +38,16 @@ namespace bodies {
 
 void evaluate() {
 	//Get positions and other data for every object in data::bodies.
-	time_t UTC = utils::getTimestamp(); //Get current UTC time (seconds)
-	for (structs::CelestialBody& body : data::bodies) {
+	evaluate(utils::getTimestamp()); //Get current UTC time (seconds)
+}
+
+void evaluate(time_t UTC) {
+	evaluate(UTC, data::bodies);
+}
+
+void evaluate(time_t UTC, std::vector<structs::CelestialBody>& bodies) {
+	PROFILE_SCOPE("bodies::evaluate");
+	for (structs::CelestialBody& body : bodies) {
 		if (body.hasParentBody) {continue; /* Do not calculate smaller bodies at this "level". Only evaluate the biggest bodies. */}
 		//Body is static, Do not simulate an orbit.
 		//Still calculate its children, however.
@@ -53,12 +62,104 @@ void evaluate() {
 }
 
 
+static double brachistochrone(double progress) {
+	//Fraction of the distance covered; Accelerate for the first half of the time, then decelerate.
+	return (progress < 0.5d) ? (2.0d * progress * progress) : (1.0d - (2.0d * (1.0d - progress) * (1.0d - progress)));
+}
+
+static double typicalDistance(const structs::CelestialBody* from, const structs::CelestialBody* to) {
+	//RMS distance between the two over every orbital phase, from the data file alone (never the current positions).
+	//Each orbit on the way up to their common parent adds its radius squared; Stars are fixed, so theirs adds as it is.
+	std::vector<const structs::CelestialBody*> chain;
+	for (const structs::CelestialBody* body=from; body; body=(body->hasParentBody) ? body->parent : nullptr) {chain.push_back(body);}
+
+	double squared = 0.0d;
+	const structs::CelestialBody* common = nullptr;
+	for (const structs::CelestialBody* body=to; body; body=(body->hasParentBody) ? body->parent : nullptr) {
+		if (std::find(chain.begin(), chain.end(), body) != chain.end()) {common = body; break;}
+		if (body->hasParentBody) {squared += static_cast<double>(body->orbitalRadius) * body->orbitalRadius;}
+		else {common = body; /* Another star; Reached from the other chain's star below. */}
+	}
+	for (const structs::CelestialBody* body : chain) {
+		if (body == common) {break;}
+		if (body->hasParentBody) {squared += static_cast<double>(body->orbitalRadius) * body->orbitalRadius;}
+		else if (common) {
+			glm::dvec2 delta = glm::dvec2(common->position - body->position);
+			squared += (delta.x * delta.x) + (delta.y * delta.y);
+		}
+	}
+	return std::sqrt(squared);
+}
+
+void calculateRoute(structs::Route* route) {
+	//Leg times from the typical distance between the locations, constant acceleration & turnover at the halfway point; t = 2*sqrt(d/a).
+	//Only the data file goes in, not the time of the first call, so a ship's position depends on UTC & the data alone. Every launch agrees.
+	size_t count = route->locations.size();
+	route->legDurations.resize(count);
+	route->period = 0;
+	for (size_t leg=0; leg<count; leg++) {
+		double distance = typicalDistance(route->locations[leg], route->locations[(leg + 1u) % count]);
+		route->legDurations[leg] = std::max(static_cast<time_t>(2.0d * std::sqrt(distance / sim::SHIP_ACCELERATION)), time_t(1));
+		route->period += route->legDurations[leg];
+	}
+}
+
+
+
+namespace routes {
+
+Leg at(const structs::Route& route, time_t UTC) {
+	time_t routeTime = UTC % route.period;
+	if (routeTime < 0) {routeTime += route.period; /* Floor, not truncation. */}
+	size_t index = 0u;
+	while (routeTime >= route.legDurations[index]) {routeTime -= route.legDurations[index++];}
+	return {index, UTC - routeTime, UTC - routeTime + route.legDurations[index]};
+}
+
+Leg next(const structs::Route& route, const Leg& leg) {
+	size_t index = (leg.index + 1u) % route.locations.size();
+	return {index, leg.end, leg.end + route.legDurations[index]};
+}
+
+}
+
+
+
 namespace spacecraft {
 	
 void evaluate() {
 	//Get positions and other data for every ship in data::spacecraft.
-	time_t UTC = utils::getTimestamp(); //Get current UTC time (seconds)
+	evaluate(utils::getTimestamp()); //Get current UTC time (seconds)
+}
+
+void evaluate(time_t UTC) {
+	evaluate(UTC, data::spacecraft);
+}
 
+void evaluate(time_t UTC, std::vector<structs::SpaceCraft>& ships) {
+	PROFILE_SCOPE("spacecraft::evaluate");
+	//Each ship flies its route in a loop, starting from the first location at UTC 0.
+	for (structs::SpaceCraft& ship : ships) {
+		structs::Route* route = ship.route;
+		size_t count = route->locations.size();
+		if (count < 2u) {continue; /* Nowhere to go. */}
+		if (route->period == 0) {calculateRoute(route);}
+
+		routes::Leg leg = routes::at(*route, UTC);
+
+		structs::Flight& journey = ship.journey;
+		journey.leg = static_cast<unsigned int>(leg.index);
+		journey.startBody = route->locations[leg.index];
+		journey.endBody = route->locations[(leg.index + 1u) % count];
+		journey.startPos = journey.startBody->position;
+		journey.endPos = journey.endBody->position;
+		journey.ETA = leg.end;
+		journey.progress = static_cast<float>(static_cast<double>(UTC - leg.start) / static_cast<double>(leg.end - leg.start));
+
+		glm::dvec2 delta = glm::dvec2(journey.endPos - journey.startPos);
+		ship.position = journey.startPos + glm::ivec2(delta * brachistochrone(journey.progress));
+		ship.getSpeed();
+	}
 }
 
 }
\ No newline at end of file
@@ -2,13 +2,31 @@
 #define PHYSICS_H
 
 
-#include "includes.h"
+#include "coreincludes.h"
 #include "constants.h"
+#include "structs.h"
 
 
 namespace bodies {
 
 	void evaluate();
+	void evaluate(time_t UTC); //Evaluate at a specific (scaled) UTC time.
+	void evaluate(time_t UTC, std::vector<structs::CelestialBody>& bodies); //As above, on another copy of the bodies.
+
+}
+
+
+namespace routes {
+
+	//One leg of a route; From locations[index] to the next location (wrapping), between start & end.
+	struct Leg {
+		size_t index;
+		time_t start;
+		time_t end;
+	};
+
+	Leg at(const structs::Route& route, time_t UTC); //The leg flown at UTC. Every route starts from its first location at UTC 0, and loops.
+	Leg next(const structs::Route& route, const Leg& leg); //The one straight after.
 
 }
 
@@ -16,6 +34,8 @@ namespace bodies {
 namespace spacecraft {
 	
 	void evaluate();
+	void evaluate(time_t UTC); //Evaluate at a specific (scaled) UTC time.
+	void evaluate(time_t UTC, std::vector<structs::SpaceCraft>& ships); //As above, on another copy of the ships.
 
 }
 
@@ -0,0 +1,241 @@
+#include "coreincludes.h"
+#include "constants.h"
+#include "utils.h"
+#include "profiler.h"
+#include "threading.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Always recording, so a hitch can be looked at after the fact;
+ - Every thread writes its scopes into its own fixed ring (dev::PROFILER_EVENTS).
+   The ring's mutex is only ever contended while a trace copies it.
+ - GPU scopes use a pool of GL_TIME_ELAPSED queries, collected in endFrame() once
+   available (a few frames later), and placed on a "GPU" track starting at the CPU time
+   the commands were submitted; GPU start times are approximate, durations are exact.
+   They are in gpuprofiler.cpp, so the simulation core can use this without OpenGL.
+ - Frames over dev::PROFILER_HITCH_MS write the last PROFILER_TRACE_FRAMES automatically.
+ - Traces copy their frames out of the rings, then format & write on threading::workers().
+\* -------------------------------------------------------------------------------- */
+
+
+typedef std::chrono::steady_clock Clock;
+
+struct Event {
+	const char* name;
+	int64_t start, duration; //Nanoseconds since the profiler epoch.
+	unsigned long long frame;
+};
+
+struct ThreadRing {
+	std::string name;
+	unsigned int id;
+	std::vector<Event> events;
+	size_t written = 0u; //Total, the ring holds the last events.size().
+	std::mutex mutex;
+};
+
+struct FrameCounters {
+	unsigned long long frame;
+	int64_t time;
+	unsigned int draws, stateChanges;
+	double frameMS;
+};
+
+static const Clock::time_point epoch = Clock::now();
+static std::atomic<unsigned long long> currentFrameNumber = 0u;
+
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<ThreadRing>> rings;
+static thread_local ThreadRing* threadRing = nullptr;
+static ThreadRing* gpuRing = nullptr;
+
+static void (*collectGPU)(bool wait) = nullptr;
+
+static std::array<FrameCounters, dev::PROFILER_TRACE_FRAMES * 4u> counters;
+static unsigned int draws = 0u, stateChanges = 0u;
+
+static unsigned long long traceFirst = 0u, traceLast = 0u;
+static bool traceArmed = false;
+static unsigned long long lastHitchTrace = 0u;
+
+
+
+static ThreadRing* newRing(const std::string& name) {
+	//Empty names the ring after its id, under the lock.
+	std::lock_guard<std::mutex> lock(registryMutex);
+	rings.push_back(std::make_unique<ThreadRing>());
+	ThreadRing* ring = rings.back().get();
+	ring->id = static_cast<unsigned int>(rings.size());
+	ring->name = (name.empty()) ? "Thread " + std::to_string(ring->id) : name;
+	ring->events.resize(dev::PROFILER_EVENTS);
+	return ring;
+}
+
+static inline ThreadRing* ring() {
+	if (!threadRing) {threadRing = newRing("");}
+	return threadRing;
+}
+
+static inline void record(ThreadRing* target, const char* name, int64_t start, int64_t duration, unsigned long long frame) {
+	std::lock_guard<std::mutex> lock(target->mutex);
+	target->events[target->written % target->events.size()] = {name, start, duration, frame};
+	target->written++;
+}
+
+
+
+struct TraceTrack {
+	unsigned int id;
+	std::string name;
+	std::vector<Event> events;
+};
+
+static void formatTrace(const std::filesystem::path& tracePath, unsigned long long firstFrame, unsigned long long lastFrame, const std::string& reason,
+						const std::vector<TraceTrack>& tracks, const std::vector<FrameCounters>& frames) {
+	std::ofstream file(tracePath);
+	if (!file) {std::cerr << "Could not write trace [" << tracePath << "]" << std::endl; return;}
+
+	file << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"reason\":\"" << reason << "\",\"firstFrame\":" << firstFrame << ",\"lastFrame\":" << lastFrame << "},\"traceEvents\":[\n";
+	file << std::fixed << std::setprecision(3);
+	bool first = true;
+	auto separator = [&]() {if (!first) {file << ",\n";} first = false;};
+
+	for (const TraceTrack& track : tracks) {
+		separator();
+		file << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << track.id << ",\"args\":{\"name\":\"" << track.name << "\"}}";
+		for (const Event& event : track.events) {
+			separator();
+			file << "{\"ph\":\"X\",\"name\":\"" << event.name << "\",\"pid\":1,\"tid\":" << track.id
+				 << ",\"ts\":" << (event.start * 1.0e-3d) << ",\"dur\":" << (event.duration * 1.0e-3d)
+				 << ",\"args\":{\"frame\":" << event.frame << "}}";
+		}
+	}
+	for (const FrameCounters& frame : frames) {
+		separator();
+		file << "{\"ph\":\"C\",\"name\":\"Frame\",\"pid\":1,\"ts\":" << (frame.time * 1.0e-3d)
+			 << ",\"args\":{\"draws\":" << frame.draws << ",\"stateChanges\":" << frame.stateChanges << ",\"frameMS\":" << frame.frameMS << "}}";
+	}
+	file << "\n]}\n";
+	std::cout << "Trace of frames " << firstFrame << "-" << lastFrame << " (" << reason << ") saved as : [" << tracePath << "]" << std::endl;
+}
+
+static void writeTrace(unsigned long long firstFrame, unsigned long long lastFrame, const std::string& reason) {
+	//Copies the frames under the locks, then formats & writes on the worker pool; Scopes only wait for the copy.
+	std::filesystem::path dirName = std::filesystem::path("saved.traces");
+	std::filesystem::create_directories(dirName);
+	std::filesystem::path tracePath = dirName / (utils::getTimestampStrPrecise() + ".json");
+
+	std::shared_ptr<std::vector<TraceTrack>> tracks = std::make_shared<std::vector<TraceTrack>>();
+	{
+		std::lock_guard<std::mutex> registryLock(registryMutex);
+		tracks->reserve(rings.size());
+		for (std::unique_ptr<ThreadRing>& threadRingPtr : rings) {
+			ThreadRing& target = *threadRingPtr;
+			TraceTrack& track = tracks->emplace_back(TraceTrack{target.id, target.name, {}});
+
+			std::lock_guard<std::mutex> lock(target.mutex);
+			size_t count = std::min(target.written, target.events.size());
+			for (size_t index=target.written-count; index<target.written; index++) {
+				const Event& event = target.events[index % target.events.size()];
+				if ((event.frame >= firstFrame) && (event.frame <= lastFrame)) {track.events.push_back(event);}
+			}
+		}
+	}
+	std::shared_ptr<std::vector<FrameCounters>> frames = std::make_shared<std::vector<FrameCounters>>();
+	for (const FrameCounters& frame : counters) {
+		if ((frame.time != 0) && (frame.frame >= firstFrame) && (frame.frame <= lastFrame)) {frames->push_back(frame);}
+	}
+
+	threading::workers().submit([tracePath, firstFrame, lastFrame, reason, tracks, frames]() {
+		formatTrace(tracePath, firstFrame, lastFrame, reason, *tracks, *frames);
+	});
+}
+
+
+
+
+namespace profiler {
+
+int64_t now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+}
+
+
+Scope::Scope(const char* name) : name(name), start(now()) {}
+
+Scope::~Scope() {
+	int64_t end = now();
+	record(ring(), name, start, end - start, currentFrameNumber);
+}
+
+
+void nameThread(const char* name) {
+	if (!threadRing) {threadRing = newRing(name);}
+	else {std::lock_guard<std::mutex> lock(registryMutex); threadRing->name = name;}
+}
+
+
+void endFrame(double frameMS) {
+	if (collectGPU) {collectGPU(false);}
+
+	unsigned long long frame = currentFrameNumber;
+	counters[frame % counters.size()] = {frame, now(), draws, stateChanges, frameMS};
+	draws = 0u;
+	stateChanges = 0u;
+
+	if (traceArmed && (frame >= traceLast)) {
+		if (collectGPU) {collectGPU(true);}
+		writeTrace(traceFirst, traceLast, "requested");
+		traceArmed = false;
+	}
+	if ((dev::PROFILER_HITCH_MS > 0.0d) && (frameMS > dev::PROFILER_HITCH_MS) && (frame > dev::PROFILER_TRACE_FRAMES) && (frame - lastHitchTrace > dev::PROFILER_TRACE_FRAMES)) {
+		//Hitch; The frames leading up to it are still in the rings.
+		writeTrace(frame - dev::PROFILER_TRACE_FRAMES + 1u, frame, "hitch of " + std::to_string(frameMS) + "ms");
+		lastHitchTrace = frame;
+	}
+	currentFrameNumber++;
+}
+
+
+
+void recordGPU(const char* name, int64_t start, int64_t duration, unsigned long long frame) {
+	if (!gpuRing) {gpuRing = newRing("GPU");}
+	record(gpuRing, name, start, duration, frame);
+}
+
+void setGPUCollector(void (*collect)(bool wait)) {
+	collectGPU = collect;
+}
+
+
+
+void countDraws(unsigned int count) {
+	draws += count;
+}
+
+void countStateChanges(unsigned int count) {
+	stateChanges += count;
+}
+
+
+
+void traceFrames(unsigned long long firstFrame, unsigned int frameCount) {
+	traceFirst = firstFrame;
+	traceLast = firstFrame + std::max(frameCount, 1u) - 1u;
+	traceArmed = true;
+}
+
+void traceRecent(unsigned int frameCount) {
+	unsigned long long frame = currentFrameNumber;
+	if (collectGPU) {collectGPU(true);}
+	writeTrace((frame > frameCount) ? (frame - frameCount) : 0u, frame, "recent");
+}
+
+unsigned long long currentFrame() {
+	return currentFrameNumber;
+}
+
+}
@@ -0,0 +1,59 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "coreincludes.h"
+#include "constants.h"
+
+
+
+
+namespace profiler {
+
+	//CPU scope; Two clock reads and one store into this thread's ring. Left on in release builds.
+	class Scope {
+	public:
+		explicit Scope(const char* name);
+		~Scope();
+	private:
+		const char* name;
+		int64_t start;
+	};
+
+	//CPU scope, plus a GL_TIME_ELAPSED query read back frames later. Render thread only, must not nest. [See gpuprofiler.cpp]
+	class GPUScope {
+	public:
+		explicit GPUScope(const char* name);
+		~GPUScope();
+	private:
+		Scope cpu;
+		int query;
+	};
+
+
+	void nameThread(const char* name); //Track name in the trace.
+	void endFrame(double frameMS); //Render thread, once per frame. Collects GPU results, writes traces that are due.
+
+	//Per-frame counters, written to the trace as counter tracks.
+	void countDraws(unsigned int count=1u);
+	void countStateChanges(unsigned int count=1u);
+
+	//Chrome trace-event JSON ("chrome://tracing" or ui.perfetto.dev), in "saved.traces/".
+	void traceFrames(unsigned long long firstFrame, unsigned int frameCount); //Written once the last frame ends.
+	void traceRecent(unsigned int frameCount=dev::PROFILER_TRACE_FRAMES); //The frames still in the rings, now.
+	unsigned long long currentFrame();
+
+	//For the GPU scopes, outside the simulation core. [See gpuprofiler.cpp]
+	int64_t now(); //Nanoseconds since the profiler epoch.
+	void recordGPU(const char* name, int64_t start, int64_t duration, unsigned long long frame);
+	void setGPUCollector(void (*collect)(bool wait)); //Called at endFrame(), and with wait=true before a trace is written.
+
+}
+
+
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) profiler::Scope PROFILER_CONCAT(profilerScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) profiler::GPUScope PROFILER_CONCAT(profilerScope, __LINE__)(name)
+
+
+#endif
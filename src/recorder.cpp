@@ -0,0 +1,173 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "threading.h"
+#include "capture.h"
+#include "recorder.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Render thread -> PBO ring (capture.cpp) -> filled queue -> writer thread -> file
+                                ^                                  |
+                                 \------------ free queue <-------/
+A fixed set of display::RECORDER_BUFFER_COUNT frames circulates between the two
+threads, so memory use is constant however long the recording runs. If the writer
+falls behind, the render thread waits for a free frame (back-pressure) rather than
+dropping one; a time-lapse must not have gaps.
+\* -------------------------------------------------------------------------------- */
+
+
+struct Session {
+	glm::ivec2 resolution;
+	time_t time, timeStep;
+	recorder::RecordingFormat format;
+	std::filesystem::path path;
+	std::FILE* file = nullptr;
+	std::vector<char> fileBuffer;
+
+	std::vector<std::vector<unsigned char>> frames; //RGBA, bottom row first.
+	threading::BoundedQueue<size_t> freeFrames, filledFrames; //Indices into frames.
+	std::thread writer;
+	std::atomic<size_t> written = 0u;
+	size_t queued = 0u;
+
+	Session(size_t frameCount) : freeFrames(frameCount), filledFrames(frameCount) {}
+};
+
+static std::unique_ptr<Session> session;
+
+
+
+static void writeFrames(Session* s) {
+	//Writer thread. The converted frame is the only other buffer, allocated once.
+	size_t width = s->resolution.x, height = s->resolution.y, pixelCount = width * height;
+	std::vector<unsigned char> converted(pixelCount * 3u);
+
+	size_t index;
+	while (s->filledFrames.pop(index)) {
+		const unsigned char* rgba = s->frames[index].data();
+		for (size_t y=0; y<height; y++) {
+			const unsigned char* source = rgba + ((height - 1u - y) * width * 4u); //Flip to top row first.
+			for (size_t x=0; x<width; x++) {
+				int R = source[(x * 4u) + 0u], G = source[(x * 4u) + 1u], B = source[(x * 4u) + 2u];
+				size_t pixel = (y * width) + x;
+				if (s->format == recorder::RF_Y4M) {
+					//BT.601, limited range. Planar Y, then U, then V.
+					converted[pixel]                    = static_cast<unsigned char>((((66 * R) + (129 * G) + (25 * B) + 128) >> 8) + 16);
+					converted[pixelCount + pixel]       = static_cast<unsigned char>((((-38 * R) - (74 * G) + (112 * B) + 128) >> 8) + 128);
+					converted[(pixelCount * 2u) + pixel] = static_cast<unsigned char>((((112 * R) - (94 * G) - (18 * B) + 128) >> 8) + 128);
+				} else {
+					converted[(pixel * 3u) + 0u] = static_cast<unsigned char>(R);
+					converted[(pixel * 3u) + 1u] = static_cast<unsigned char>(G);
+					converted[(pixel * 3u) + 2u] = static_cast<unsigned char>(B);
+				}
+			}
+		}
+		s->freeFrames.push(index); //Hand the frame back as soon as it is converted.
+
+		if (s->format == recorder::RF_Y4M) {std::fputs("FRAME\n", s->file);}
+		std::fwrite(converted.data(), 1u, converted.size(), s->file);
+		s->written++;
+	}
+}
+
+
+
+
+namespace recorder {
+
+bool start(glm::ivec2 resolution, time_t startTime, time_t timeStep, RecordingFormat format) {
+	if (session) {return false; /* Already recording. */}
+	if ((resolution.x <= 0) || (resolution.y <= 0)) {return false;}
+
+	std::filesystem::path dirName = std::filesystem::path("saved.recordings");
+	std::filesystem::create_directories(dirName);
+
+	std::unique_ptr<Session> s = std::make_unique<Session>(display::RECORDER_BUFFER_COUNT);
+	s->resolution = resolution;
+	s->time = startTime;
+	s->timeStep = timeStep;
+	s->format = format;
+	s->path = dirName / (utils::getTimestampStrPrecise() + ((format == RF_Y4M) ? ".y4m" : ".rgb"));
+	s->file = std::fopen(s->path.string().c_str(), "wb");
+	if (!s->file) {
+		std::cerr << "Could not open [" << s->path << "] for recording." << std::endl;
+		return false;
+	}
+	s->fileBuffer.resize(1u << 20u);
+	std::setvbuf(s->file, s->fileBuffer.data(), _IOFBF, s->fileBuffer.size());
+	if (format == RF_Y4M) {
+		std::fprintf(s->file, "YUV4MPEG2 W%d H%d F%u:1 Ip A1:1 C444\n", resolution.x, resolution.y, display::RECORDER_FPS);
+	}
+
+	s->frames.resize(display::RECORDER_BUFFER_COUNT);
+	for (size_t index=0; index<s->frames.size(); index++) {
+		s->frames[index].resize(static_cast<size_t>(resolution.x) * resolution.y * 4u);
+		s->freeFrames.push(index);
+	}
+	s->writer = std::thread(writeFrames, s.get());
+
+	std::cout << "Recording time-lapse to [" << s->path << "] : " << timeStep << " sim seconds per frame." << std::endl;
+	if (format == RF_RGB) {
+		std::cout << "Play with; ffmpeg -f rawvideo -pix_fmt rgb24 -s " << resolution.x << "x" << resolution.y << " -r " << display::RECORDER_FPS << " -i " << s->path << std::endl;
+	}
+	session = std::move(s);
+	return true;
+}
+
+
+void stop() {
+	if (!session) {return;}
+	capture::flush(); //Frames still in the PBO ring.
+	session->filledFrames.close();
+	session->writer.join();
+	std::fclose(session->file);
+
+	std::cout << "Recording stopped : " << session->written << " frames (" << (session->written * session->timeStep) << " sim seconds) saved as : [" << session->path << "]" << std::endl;
+	session.reset();
+}
+
+
+bool recording() {
+	return session != nullptr;
+}
+
+
+
+time_t frameTime() {
+	return (session) ? session->time : utils::getTimestamp();
+}
+
+
+void captureFrame(GLuint FBO, glm::ivec2 resolution) {
+	if (!session) {return;}
+	if (resolution != session->resolution) {
+		std::cout << "Resolution changed, the recording can not continue." << std::endl;
+		stop();
+		return;
+	}
+
+	Session* s = session.get();
+	capture::ReadbackCallback callback = [s](const unsigned char* pixels, glm::ivec2 resolution) {
+		size_t index;
+		if (!s->freeFrames.pop(index)) {return;} //Blocks while the writer is behind.
+		std::memcpy(s->frames[index].data(), pixels, s->frames[index].size());
+		s->filledFrames.push(index);
+	};
+	while (!capture::requestFramebuffer(FBO, s->resolution, callback)) {
+		capture::flushOldest(); //Ring full, wait on the GPU rather than drop a frame.
+	}
+
+	s->time += s->timeStep;
+	s->queued++;
+}
+
+
+size_t framesWritten() {
+	return (session) ? session->written.load() : 0u;
+}
+
+}
@@ -0,0 +1,30 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include "includes.h"
+#include "constants.h"
+
+
+
+
+namespace recorder {
+
+	enum RecordingFormat {
+		RF_Y4M, //YUV4MPEG2, 4:4:4. Plays in most video tools directly.
+		RF_RGB  //Raw RGB24 frames, top row first.
+	};
+
+
+	//Time-lapse; Every frame is rendered at a fixed sim-time step, then streamed to disk.
+	bool start(glm::ivec2 resolution, time_t startTime, time_t timeStep, RecordingFormat format=RF_Y4M);
+	void stop(); //Writes every queued frame before returning.
+	bool recording();
+
+	time_t frameTime(); //Sim time to render the current frame at.
+	void captureFrame(GLuint FBO, glm::ivec2 resolution); //Call after drawing. Queues the readback, then advances the sim time.
+	size_t framesWritten();
+
+}
+
+
+#endif
@@ -0,0 +1,84 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "redraw.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Event driven redraw; Bodies only move when the (scaled) UTC second ticks over, so most
+60 Hz frames used to redraw exactly the same picture.
+ - Anything that changes what is on screen marks a frame due; The simulation thread when
+   a snapshot differs from the last, key presses, and window resizes/exposes/restores.
+ - With nothing due, the render thread sleeps in glfwWaitEventsTimeout() rather than
+   drawing. The simulation thread wakes it (glfwPostEmptyEvent) on the next change.
+ - Minimised windows never draw; Their marks are kept until the window is restored.
+\* -------------------------------------------------------------------------------- */
+
+
+static std::atomic<unsigned int> marked = redraw::RR_WINDOW; //The first frame.
+static std::atomic<bool> iconified = false;
+
+
+
+static void refreshCallback(GLFWwindow* window) {
+	redraw::mark(redraw::RR_WINDOW); //Exposed; The back buffer is stale.
+}
+
+static void focusCallback(GLFWwindow* window, int focused) {
+	redraw::mark(redraw::RR_WINDOW);
+}
+
+static void iconifyCallback(GLFWwindow* window, int minimised) {
+	iconified = (minimised == GLFW_TRUE);
+	redraw::mark(redraw::RR_WINDOW);
+}
+
+static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	if (action != GLFW_REPEAT) {redraw::mark(redraw::RR_INPUT); /* Read by handleInputs() with glfwGetKey(). */}
+}
+
+
+
+
+namespace redraw {
+
+void attach(GLFWwindow* window) {
+	glfwSetWindowRefreshCallback(window, refreshCallback);
+	glfwSetWindowFocusCallback(window, focusCallback);
+	glfwSetWindowIconifyCallback(window, iconifyCallback);
+	glfwSetKeyCallback(window, keyCallback);
+	mark(RR_WINDOW); //First frame.
+}
+
+
+void mark(unsigned int reasons) {
+	marked.fetch_or(reasons, std::memory_order_release);
+}
+
+void wake(unsigned int reasons) {
+	mark(reasons);
+	glfwPostEmptyEvent();
+}
+
+
+void wait() {
+	if (due()) {
+		glfwPollEvents();
+	} else {
+		glfwWaitEventsTimeout(display::IDLE_WAIT_S);
+	}
+}
+
+
+bool due() {
+	return !iconified && (marked.load(std::memory_order_acquire) != 0u);
+}
+
+unsigned int take() {
+	return marked.exchange(0u, std::memory_order_acq_rel);
+}
+
+}
@@ -0,0 +1,33 @@
+#ifndef REDRAW_H
+#define REDRAW_H
+
+#include "includes.h"
+#include "constants.h"
+
+
+
+
+namespace redraw {
+
+	//Why a frame is due; Marks accumulate until take().
+	enum Reason : unsigned int {
+		RR_SIMULATION = 1u << 0u,	//A published snapshot differs from the one before it.
+		RR_INPUT      = 1u << 1u,	//A key was pressed or released (Views, captures...)
+		RR_WINDOW     = 1u << 2u,	//Resized, exposed, restored or (un)focussed.
+		RR_TEXTURES   = 1u << 3u,	//Placeholders still waiting for their textures.
+		RR_CAPTURE    = 1u << 4u,	//Recording or continuously capturing; Every frame.
+	};
+
+
+	void attach(GLFWwindow* window); //Window callbacks that mark a frame due. The framebuffer size callback stays with main.
+	void mark(unsigned int reasons); //Any thread.
+	void wake(unsigned int reasons); //Any thread; mark(), then wake the render thread if it is waiting.
+
+	void wait(); //Render thread, instead of glfwPollEvents; Waits for events (at most display::IDLE_WAIT_S) unless a frame is already due.
+	bool due(); //Something visible changed, and the window is not minimised.
+	unsigned int take(); //The reasons marked since the last take(), clearing them.
+
+}
+
+
+#endif
@@ -0,0 +1,244 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "threading.h"
+#include "profiler.h"
+#include "physics.h"
+#include "schedule.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Arrivals & departures boards, per body; Kept up to date by leg events, not by scanning.
+ - Every ship flies its route in a fixed loop, so the end of its current leg is known in
+   advance. That is one event per ship, in a calendar queue; sim::SCHEDULE_BUCKETS buckets
+   of sim::SCHEDULE_BUCKET_SECONDS, wrapping. Inserting is O(1), and each tick only visits
+   the buckets sim time passed through, popping the events that are due.
+ - A popped event moves the ship from its destination's arrivals to its departures, adds
+   it to the next destination's arrivals, and schedules the end of its next leg.
+ - Arrivals are ordered sets per body, departures the latest few. Only the boards of the
+   bodies events touched are rebuilt, and published through a TripleBuffer.
+ - Time running backwards (a journal seek) or jumping more than the calendar spans
+   rebuilds everything from each ship's Flight, once. The next leg always comes from
+   routes::next(), the same leg walk spacecraft::evaluate() uses.
+A tick costs O(events due + buckets passed), however many ships are in flight.
+\* -------------------------------------------------------------------------------- */
+
+
+//The ship reaches the end of this leg of its route.
+struct Event {
+	time_t time;
+	uint32_t ship;
+	uint32_t leg;
+};
+
+static std::vector<std::vector<Event>> calendar(sim::SCHEDULE_BUCKETS);
+static time_t cursor = 0; //Every event before this has been popped.
+static bool built = false;
+static std::vector<Event> due; //Min-heap by time; Popped this tick.
+
+static std::vector<std::set<std::pair<time_t, uint32_t>>> inbound; //Per body; (ETA, ship).
+static std::vector<std::deque<schedule::Row>> outbound; //Per body; Latest first.
+static std::vector<uint32_t> shipLegs; //Current leg per ship.
+static std::vector<schedule::Board> boards; //Per body.
+static std::vector<uint32_t> dirty;
+static std::vector<bool> isDirty;
+static threading::TripleBuffer<std::vector<schedule::Board>> published;
+
+//Render thread;
+static bool shown = false;
+static const schedule::Board emptyBoard;
+
+
+
+static inline time_t bucketOf(time_t time) {
+	time_t bucket = time / sim::SCHEDULE_BUCKET_SECONDS;
+	if ((time % sim::SCHEDULE_BUCKET_SECONDS) < 0) {bucket--; /* Floor, not truncation. */}
+	return bucket;
+}
+
+static inline std::vector<Event>& bucketFor(time_t bucket) {
+	time_t count = static_cast<time_t>(sim::SCHEDULE_BUCKETS);
+	return calendar[static_cast<size_t>(((bucket % count) + count) % count)];
+}
+
+static const auto later = [](const Event& a, const Event& b) {return a.time > b.time;};
+
+
+static void push(const Event& event, time_t UTC) {
+	//Already due (a leg shorter than the tick), or into the calendar.
+	if (event.time <= UTC) {
+		due.push_back(event);
+		std::push_heap(due.begin(), due.end(), later);
+	} else {
+		bucketFor(bucketOf(event.time)).push_back(event);
+	}
+}
+
+static void touch(uint32_t body) {
+	if (isDirty[body]) {return;}
+	isDirty[body] = true;
+	dirty.push_back(body);
+}
+
+static void depart(uint32_t body, const schedule::Row& row) {
+	std::deque<schedule::Row>& rows = outbound[body];
+	rows.push_front(row);
+	if (rows.size() > display::BOARD_ROWS) {rows.pop_back();}
+	touch(body);
+}
+
+
+static void rebuild(time_t UTC, const std::vector<structs::CelestialBody>& bodies, const std::vector<structs::SpaceCraft>& ships) {
+	//Every ship's current leg, from its Flight.
+	PROFILE_SCOPE("schedule::rebuild");
+	for (std::vector<Event>& bucket : calendar) {bucket.clear();}
+	due.clear();
+	inbound.assign(bodies.size(), {});
+	outbound.assign(bodies.size(), {});
+	shipLegs.assign(ships.size(), 0u);
+	boards.resize(bodies.size());
+	isDirty.assign(bodies.size(), false);
+	dirty.clear();
+	for (uint32_t body=0; body<bodies.size(); body++) {touch(body);}
+
+	std::vector<std::vector<schedule::Row>> departed(bodies.size());
+	for (uint32_t index=0; index<ships.size(); index++) {
+		//From the ship's Flight, as spacecraft::evaluate() left it.
+		const structs::Route* route = ships[index].route;
+		const structs::Flight& journey = ships[index].journey;
+		if (!route || (route->locations.size() < 2u) || (route->period == 0) || !journey.startBody || !journey.endBody) {continue; /* Not flying. */}
+		time_t ETA = journey.ETA;
+		uint32_t origin = static_cast<uint32_t>(journey.startBody - bodies.data());
+		uint32_t destination = static_cast<uint32_t>(journey.endBody - bodies.data());
+		shipLegs[index] = journey.leg;
+		inbound[destination].insert({ETA, index});
+		departed[origin].push_back({index, destination, ETA - route->legDurations[journey.leg]});
+		push({ETA, index, journey.leg}, UTC);
+	}
+
+	for (uint32_t body=0; body<bodies.size(); body++) {
+		//Only the latest few departures are kept.
+		std::vector<schedule::Row>& rows = departed[body];
+		size_t kept = std::min<size_t>(rows.size(), display::BOARD_ROWS);
+		std::partial_sort(rows.begin(), rows.begin() + kept, rows.end(), [](const schedule::Row& a, const schedule::Row& b) {return a.time > b.time;});
+		outbound[body].assign(rows.begin(), rows.begin() + kept);
+	}
+	cursor = UTC + 1;
+	built = true;
+}
+
+
+static void arrive(const Event& event, time_t UTC, const std::vector<structs::CelestialBody>& bodies, const std::vector<structs::SpaceCraft>& ships) {
+	//At the end of one leg, straight onto the next.
+	const structs::Route& route = *ships[event.ship].route;
+	routes::Leg finished = {event.leg, event.time - route.legDurations[event.leg], event.time};
+	routes::Leg leg = routes::next(route, finished);
+	uint32_t body = static_cast<uint32_t>(route.locations[leg.index] - bodies.data());
+	uint32_t destination = static_cast<uint32_t>(route.locations[(leg.index + 1u) % route.locations.size()] - bodies.data());
+
+	inbound[body].erase({event.time, event.ship});
+	touch(body);
+	depart(body, {event.ship, destination, event.time});
+	inbound[destination].insert({leg.end, event.ship});
+	touch(destination);
+	shipLegs[event.ship] = static_cast<uint32_t>(leg.index);
+	push({leg.end, event.ship, static_cast<uint32_t>(leg.index)}, UTC);
+}
+
+
+static void publish(const std::vector<structs::CelestialBody>& bodies, const std::vector<structs::SpaceCraft>& ships) {
+	//Rebuild the touched boards, then copy every board the back slot is behind on.
+	for (uint32_t body : dirty) {
+		schedule::Board& board = boards[body];
+		board.arrivals.clear();
+		for (const std::pair<time_t, uint32_t>& arrival : inbound[body]) {
+			if (board.arrivals.size() >= display::BOARD_ROWS) {break;}
+			const structs::Route* route = ships[arrival.second].route;
+			uint32_t origin = static_cast<uint32_t>(route->locations[shipLegs[arrival.second]] - bodies.data());
+			board.arrivals.push_back({arrival.second, origin, arrival.first});
+		}
+		board.departures.assign(outbound[body].begin(), outbound[body].end());
+		board.version++;
+		isDirty[body] = false;
+	}
+	dirty.clear();
+
+	std::vector<schedule::Board>& slot = published.back();
+	slot.resize(boards.size());
+	for (size_t body=0; body<boards.size(); body++) {
+		if (slot[body].version != boards[body].version) {slot[body] = boards[body];}
+	}
+	published.publish();
+}
+
+
+
+
+namespace schedule {
+
+void advance(time_t UTC, const std::vector<structs::CelestialBody>& bodies, const std::vector<structs::SpaceCraft>& ships) {
+	PROFILE_SCOPE("schedule::advance");
+	time_t span = static_cast<time_t>(sim::SCHEDULE_BUCKETS) * sim::SCHEDULE_BUCKET_SECONDS;
+	if (!built || (UTC < cursor - 1) || (UTC - cursor >= span) || (shipLegs.size() != ships.size())) {
+		rebuild(UTC, bodies, ships);
+		publish(bodies, ships);
+		return;
+	}
+	if (UTC < cursor) {return; /* Same second as last tick. */}
+
+	//Only the buckets sim time passed through since the last tick.
+	for (time_t bucket=bucketOf(cursor); bucket<=bucketOf(UTC); bucket++) {
+		std::vector<Event>& events = bucketFor(bucket);
+		for (size_t index=0; index<events.size();) {
+			if (events[index].time > UTC) {index++; continue; /* Later, or a later lap of the calendar. */}
+			due.push_back(events[index]);
+			std::push_heap(due.begin(), due.end(), later);
+			events[index] = events.back();
+			events.pop_back();
+		}
+	}
+
+	//In time order, so departures stay latest first.
+	while (!due.empty()) {
+		std::pop_heap(due.begin(), due.end(), later);
+		Event event = due.back();
+		due.pop_back();
+		arrive(event, UTC, bodies, ships);
+	}
+	cursor = UTC + 1;
+	if (!dirty.empty()) {publish(bodies, ships);}
+}
+
+
+
+bool update() {
+	return published.acquire();
+}
+
+const Board& board(size_t bodyIndex) {
+	const std::vector<Board>& front = published.front();
+	return (bodyIndex < front.size()) ? front[bodyIndex] : emptyBoard;
+}
+
+bool visible() {
+	return shown;
+}
+
+void toggle() {
+	shown = !shown;
+	std::cout << "Arrivals & departures boards " << ((shown) ? "shown" : "hidden") << "." << std::endl;
+}
+
+
+std::string formatTime(time_t UTC) {
+	struct tm* time = std::gmtime(&UTC);
+	if (!time) {return "--";}
+	std::ostringstream oss;
+	oss << std::put_time(time, "%m-%d %H:%M");
+	return oss.str();
+}
+
+}
@@ -0,0 +1,41 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include "includes.h"
+#include "constants.h"
+#include "global.h"
+
+
+
+
+namespace schedule {
+
+	//One line of a board.
+	struct Row {
+		uint32_t ship;	//Index in data::spacecraft.
+		uint32_t body;	//Arrivals; Where from. Departures; Where to. Index in data::bodies.
+		time_t time;	//Arrivals; ETA. Departures; When it left.
+	};
+
+	//A body's arrivals & departures, as published to the render thread.
+	struct Board {
+		std::vector<Row> arrivals;		//Soonest first, at most display::BOARD_ROWS.
+		std::vector<Row> departures;	//Latest first, at most display::BOARD_ROWS.
+		unsigned long long version = 0u; //Changes whenever the rows do.
+	};
+
+
+	//Simulation thread; Every tick, after the ships are evaluated. Pops the leg events due by UTC and schedules each ship's next leg.
+	void advance(time_t UTC, const std::vector<structs::CelestialBody>& bodies, const std::vector<structs::SpaceCraft>& ships);
+
+	//Render thread;
+	bool update(); //Newest boards, if any changed. True if they did.
+	const Board& board(size_t bodyIndex);
+	bool visible();
+	void toggle(); //[B]
+	std::string formatTime(time_t UTC); //"MM-DD HH:MM", sim time.
+
+}
+
+
+#endif
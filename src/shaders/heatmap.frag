@@ -0,0 +1,53 @@
+/* heatmap.frag */
+#version 460 core
+
+layout(std430, binding=1) readonly buffer BodyPositions {ivec2 positions[];};
+
+layout(std140, binding=0) uniform View {
+	mat4 projectionMatrix;
+	ivec2 offset;
+	ivec2 resolution;
+	int focusIndex;
+	float scaling;
+	uint orbitBase;
+	uint spriteBase;
+	uint staticBase;
+}; //Per viewport. [viewports::ViewUniforms]
+
+layout(binding=0) uniform sampler2DArray density; //One layer per level, ships per finest cell's area. [heatmap::Density]
+uniform int body; //The grids' centre.
+uniform int levels;
+uniform int cells; //Per level, a side.
+uniform float extent; //Half width of the finest level.
+uniform float levelScale;
+uniform float maxDensity;
+uniform float opacity;
+
+in vec2 fragUV;
+out vec4 fragColour;
+
+
+vec3 heat(float value) {
+	//Black body; Red, through yellow, to white. [heatmap::heat()]
+	return clamp(vec3(value * 3.0f, (value * 3.0f) - 1.0f, (value * 3.0f) - 2.0f), 0.0f, 1.0f);
+}
+
+void main() {
+	//Back from view pixels to the body's frame, as the sprites are projected.
+	vec2 pixel = fragUV * vec2(resolution);
+	vec2 position = ((pixel - vec2(offset) - vec2(resolution / 2)) / scaling) + vec2(positions[focusIndex] - positions[body]);
+
+	//Finest level that holds it, as binned in heatmap.cpp.
+	float reach = max(abs(position.x), abs(position.y));
+	float halfWidth = extent;
+	int level = 0;
+	while ((level < levels) && (reach >= halfWidth)) {halfWidth *= levelScale; level++;}
+	if (level == levels) {discard; /* Beyond the coarsest level. */}
+
+	ivec2 cell = clamp(ivec2(floor((position + halfWidth) / (2.0f * halfWidth) * float(cells))), ivec2(0), ivec2(cells - 1));
+	float value = texelFetch(density, ivec3(cell, level), 0).r;
+	if (value <= 0.0f) {discard; /* No traffic. */}
+
+	float normalised = log(1.0f + value) / log(1.0f + maxDensity);
+	fragColour = vec4(heat(normalised), opacity * mix(0.25f, 1.0f, normalised));
+}
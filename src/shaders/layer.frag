@@ -0,0 +1,13 @@
+/* layer.frag */
+#version 460 core
+
+layout(binding=0) uniform sampler2D layer; //Nearest, one texel per pixel.
+
+in vec2 fragUV;
+out vec4 fragColour;
+
+
+void main() {
+	fragColour = texture(layer, fragUV);
+	if (fragColour.a == 0.0f) {discard; /* Nothing cached here. */}
+}
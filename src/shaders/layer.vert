@@ -0,0 +1,18 @@
+/* layer.vert */
+#version 460 core
+
+out vec2 fragUV;
+
+
+const vec2 v[4] = {
+	vec2(0.0f, 0.0f),
+	vec2(1.0f, 0.0f),
+	vec2(0.0f, 1.0f),
+	vec2(1.0f, 1.0f),
+};
+
+void main() {
+	//One quad over the whole GL viewport, the layer being the same size.
+	gl_Position = vec4((v[gl_VertexID] * 2.0f) - 1.0f, 0.0f, 1.0f);
+	fragUV = v[gl_VertexID];
+}
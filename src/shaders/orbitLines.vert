@@ -3,19 +3,64 @@
 
 layout(location=0) in vec2 aPos;
 out vec2 fragPosition;
+flat out ivec2 fragCentre;
+flat out ivec2 fragBodyPosition;
+flat out vec3 fragOrbitColour;
 
+struct Body {
+	vec4 colour;
+	int parent;
+	uint radius;
+	float orbitalRadius;
+	float orbitalPeriod;
+	uvec2 phaseStep;
+};
 
-uniform ivec2 centre;
-uniform float radius;
-uniform float scaling;
-uniform ivec2 offset;
-uniform mat4 projectionMatrix;
-uniform ivec2 resolution;
+layout(std430, binding=0) readonly buffer BodyElements {Body bodies[];};
+layout(std430, binding=1) readonly buffer BodyPositions {ivec2 positions[];};
+layout(std430, binding=5) readonly buffer VisibleBodies {uint visible[];}; //Culled, per view.
+
+
+layout(std140, binding=0) uniform View {
+	mat4 projectionMatrix;
+	ivec2 offset;
+	ivec2 resolution;
+	int focusIndex;
+	float scaling;
+	uint orbitBase;
+	uint spriteBase;
+	uint staticBase;
+}; //Per viewport. [viewports::ViewUniforms]
+
+uniform int mode; //0; Moving rings. 1; Static rings, plain (the cached layer). 2; Highlight arcs of the static rings.
+uniform int arcVertices; //Mode 2, centred on the body.
+
+#define NUM_LINE_SEGMENTS 512
+#define TAU 6.28318530718f
 
 
 void main() {
-    vec2 pos = centre + (aPos * radius);
+	//One instance per visible orbit, relative to the focussed body.
+	uint index = visible[((mode == 0) ? orbitBase : staticBase) + uint(gl_InstanceID)];
+	Body body = bodies[index];
+	if (body.parent < 0) {
+		gl_Position = vec4(2.0f, 2.0f, 2.0f, 1.0f); //No orbit line to draw, outside clip space.
+		return;
+	}
+
+	ivec2 centre = positions[body.parent] - positions[focusIndex];
+	vec2 circle = aPos;
+	if (mode == 2) {
+		//Only the segments of the ring around the body, on the same vertices as the whole ring beneath it.
+		vec2 toBody = vec2(positions[index] - positions[body.parent]);
+		int first = int(floor(atan(toBody.y, toBody.x) * float(NUM_LINE_SEGMENTS) / TAU)) - (arcVertices / 2) + 1;
+		float theta = TAU * float(first + gl_VertexID) / float(NUM_LINE_SEGMENTS);
+		circle = vec2(cos(theta), sin(theta));
+	}
+    vec2 pos = centre + (circle * body.orbitalRadius);
     gl_Position = projectionMatrix * vec4(pos.xy * scaling + offset + (resolution / 2), 0.0f, 1.0f);
     fragPosition = pos;
+	fragCentre = centre;
+	fragBodyPosition = positions[index] - positions[focusIndex];
+	fragOrbitColour = body.colour.rgb;
 }
-
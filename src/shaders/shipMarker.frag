@@ -0,0 +1,16 @@
+/* shipMarker.frag */
+#version 460 core
+
+in vec2 fragUV;
+flat in float fragWeight;
+out vec4 fragColour;
+
+#define SHIP_COLOUR vec3(0.25f, 0.85f, 1.0f)
+#define WHITE_WEIGHT 16.0f //Clusters of 2^16 ships and over are white.
+
+void main() {
+	float distance = length(fragUV);
+	if (distance > 1.0f) {discard;}
+	vec3 colour = mix(SHIP_COLOUR, vec3(1.0f, 1.0f, 1.0f), clamp(fragWeight / WHITE_WEIGHT, 0.0f, 1.0f));
+	fragColour = vec4(colour, 1.0f - smoothstep(0.7f, 1.0f, distance)); //Soft edged disc.
+}
@@ -0,0 +1,46 @@
+/* shipMarker.vert */
+#version 460 core
+
+out vec2 fragUV;
+flat out float fragWeight;
+
+struct Marker {
+	ivec2 position;
+	uint count;
+	uint ship;
+};
+
+layout(std430, binding=6) readonly buffer ShipMarkers {Marker markers[];}; //Per view, individual ships first. [clusters.cpp]
+
+
+layout(std140, binding=0) uniform View {
+	mat4 projectionMatrix;
+	ivec2 offset;
+	ivec2 resolution;
+	int focusIndex;
+	float scaling;
+	uint orbitBase;
+	uint spriteBase;
+	uint staticBase;
+}; //Per viewport. [viewports::ViewUniforms]
+
+#define SHIP_RADIUS 2.5f
+#define CLUSTER_RADIUS_MAX 7.0f
+
+
+const vec2 v[4] = {
+	vec2(-1.0f, -1.0f),
+	vec2( 1.0f, -1.0f),
+	vec2(-1.0f,  1.0f),
+	vec2( 1.0f,  1.0f),
+};
+
+void main() {
+	//One instance per marker, already in viewport pixels. Clusters grow with the log of their count.
+	Marker marker = markers[gl_BaseInstance + gl_InstanceID];
+	float weight = log2(float(marker.count)); //0 for a single ship.
+	float radius = min(SHIP_RADIUS * (1.0f + (0.5f * weight)), CLUSTER_RADIUS_MAX);
+	gl_Position = projectionMatrix * vec4(vec2(marker.position) + 0.5f + (v[gl_VertexID] * radius), 0.0f, 1.0f);
+	fragUV = v[gl_VertexID];
+	fragWeight = weight;
+}
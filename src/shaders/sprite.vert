@@ -4,12 +4,30 @@
 
 out vec2 fragUV;
 
-uniform ivec2 centre;
-uniform uint radius;
-uniform float scaling;
-uniform ivec2 offset;
-uniform mat4 projectionMatrix;
-uniform ivec2 resolution;
+struct Body {
+	vec4 colour;
+	int parent;
+	uint radius;
+	float orbitalRadius;
+	float orbitalPeriod;
+	uvec2 phaseStep;
+};
+
+layout(std430, binding=0) readonly buffer BodyElements {Body bodies[];};
+layout(std430, binding=1) readonly buffer BodyPositions {ivec2 positions[];};
+layout(std430, binding=5) readonly buffer VisibleBodies {uint visible[];}; //Culled, per view.
+
+
+layout(std140, binding=0) uniform View {
+	mat4 projectionMatrix;
+	ivec2 offset;
+	ivec2 resolution;
+	int focusIndex;
+	float scaling;
+	uint orbitBase;
+	uint spriteBase;
+	uint staticBase;
+}; //Per viewport. [viewports::ViewUniforms]
 
 
 const vec2 v[4] = {
@@ -20,7 +38,10 @@ const vec2 v[4] = {
 };
 
 void main() {
-    vec2 pos = centre + (v[gl_VertexID] * float(radius));
+	//One instance per visible body.
+	uint index = visible[spriteBase + uint(gl_InstanceID)];
+	ivec2 centre = positions[index] - positions[focusIndex];
+    vec2 pos = centre + (v[gl_VertexID] * float(bodies[index].radius));
     gl_Position = projectionMatrix * vec4(pos.xy * scaling + offset + (resolution / 2), 0.0f, 1.0f);
 	fragUV = clamp(v[gl_VertexID], 0.0f, 1.0f);
 }
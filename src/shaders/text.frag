@@ -0,0 +1,14 @@
+/* text.frag */
+#version 460 core
+
+uniform sampler2D glyphAtlas;
+
+in vec2 fragUV;
+flat in vec4 fragGlyphColour;
+out vec4 fragColour;
+
+
+void main() {
+	if (texture(glyphAtlas, fragUV).r < 0.5f) {discard;}
+	fragColour = fragGlyphColour;
+}
@@ -0,0 +1,42 @@
+/* text.vert */
+#version 460 core
+
+out vec2 fragUV;
+flat out vec4 fragGlyphColour;
+
+struct Glyph {
+	ivec2 position;
+	uint glyph;
+	uint colour;
+};
+
+layout(std430, binding=4) readonly buffer LabelGlyphs {Glyph glyphs[];};
+
+
+uniform mat4 projectionMatrix;
+uniform int glyphScale;
+
+#define GLYPH_SIZE vec2(5.0f, 7.0f)
+#define ATLAS_CELL 8u
+#define ATLAS_COLUMNS 16u
+#define ATLAS_SIZE vec2(128.0f, 32.0f)
+
+
+const vec2 v[4] = {
+	vec2(0.0f, 0.0f),
+	vec2(1.0f, 0.0f),
+	vec2(0.0f, 1.0f),
+	vec2(1.0f, 1.0f),
+};
+
+void main() {
+	//One instance per glyph, already in render pixels.
+	Glyph glyph = glyphs[gl_InstanceID];
+	vec2 corner = v[gl_VertexID];
+	vec2 pos = vec2(glyph.position) + (corner * GLYPH_SIZE * float(glyphScale));
+    gl_Position = projectionMatrix * vec4(pos, 0.0f, 1.0f);
+
+	uvec2 cell = uvec2(glyph.glyph % ATLAS_COLUMNS, glyph.glyph / ATLAS_COLUMNS) * ATLAS_CELL;
+	fragUV = (vec2(cell) + (corner * GLYPH_SIZE)) / ATLAS_SIZE;
+	fragGlyphColour = unpackUnorm4x8(glyph.colour);
+}
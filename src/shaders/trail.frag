@@ -0,0 +1,11 @@
+/* trail.frag */
+#version 460 core
+
+in float fragAlpha;
+out vec4 fragColour;
+
+#define TRAIL_COLOUR vec3(0.25f, 0.85f, 1.0f)
+
+void main() {
+	fragColour = vec4(TRAIL_COLOUR, fragAlpha);
+}
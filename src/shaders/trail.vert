@@ -0,0 +1,45 @@
+/* trail.vert */
+#version 460 core
+
+out float fragAlpha;
+
+layout(std430, binding=1) readonly buffer BodyPositions {ivec2 positions[];};
+layout(std430, binding=3) readonly buffer ShipTrails {ivec2 samples[];}; //[slot * shipCount + ship]
+
+struct Marker {
+	ivec2 position;
+	uint count;
+	uint ship;
+};
+
+layout(std430, binding=6) readonly buffer ShipMarkers {Marker markers[];}; //Per view, individual ships first. [clusters.cpp]
+
+
+layout(std140, binding=0) uniform View {
+	mat4 projectionMatrix;
+	ivec2 offset;
+	ivec2 resolution;
+	int focusIndex;
+	float scaling;
+	uint orbitBase;
+	uint spriteBase;
+	uint staticBase;
+}; //Per viewport. [viewports::ViewUniforms]
+
+uniform uint head;
+uniform uint capacity;
+uniform uint shipCount;
+uniform uint trailLength; //Vertices drawn per trail.
+uniform float fade;
+
+
+void main() {
+	//One instance per individually drawn ship, vertex 0 is the newest sample.
+	uint ship = markers[gl_BaseInstance + gl_InstanceID].ship;
+	uint age = uint(gl_VertexID);
+	uint slot = (head + capacity - age) % capacity;
+
+	ivec2 pos = samples[(slot * shipCount) + ship] - positions[focusIndex];
+    gl_Position = projectionMatrix * vec4(vec2(pos) * scaling + offset + (resolution / 2), 0.0f, 1.0f);
+	fragAlpha = pow(1.0f - (float(age) / float(trailLength)), fade);
+}
@@ -0,0 +1,194 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "threading.h"
+#include "physics.h"
+#include "simulation.h"
+#include "profiler.h"
+#include "telemetry.h"
+#include "broadcast.h"
+#include "journal.h"
+#include "redraw.h"
+#include "heatmap.h"
+#include "schedule.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Simulation thread ---> TripleBuffer<Snapshot> ---> Render thread
+ - The simulation thread owns a private copy of the bodies, routes & ships (pointers
+   re-targeted into the copy), so it never touches data:: while the render thread reads it.
+ - Each tick it evaluates, fills the back snapshot and publishes it. Lock-free.
+ - Live telemetry corrects the predicted ship positions each tick. [See telemetry.cpp]
+ - Each tick is also sent to remote consoles, or received from a server. [See broadcast.cpp]
+ - Each tick can be journaled, or replayed from a journal in place of the ships. [See journal.cpp]
+ - Each tick's ship positions can be binned into a traffic heatmap. [See heatmap.cpp]
+ - Each tick pops the ship leg events that fell due, for the arrivals boards. [See schedule.cpp]
+ - The render thread applies the newest snapshot once per frame. A slow tick never
+   delays a frame (it redraws the previous snapshot), and a slow frame never delays a tick.
+ - A snapshot that differs from the one before wakes the render thread, which otherwise
+   sleeps while nothing on screen changes. [See redraw.cpp]
+Fixed-step time-lapse recording still evaluates on the render thread.
+\* -------------------------------------------------------------------------------- */
+
+
+typedef std::chrono::steady_clock Clock;
+
+static std::vector<structs::CelestialBody> simBodies;
+static std::vector<structs::Route> simRoutes;
+static std::vector<structs::SpaceCraft> simShips;
+
+static threading::TripleBuffer<simulation::Snapshot> snapshots;
+static std::thread simThread;
+static std::atomic<bool> simRunning = false;
+static std::atomic<unsigned long long> published = 0u;
+static uint64_t publishedDigest = 0u; //Of the last snapshot, to tell when one changes.
+
+
+
+template<typename T>
+static inline T* retarget(T* pointer, const std::vector<T>& from, std::vector<T>& to) {
+	return (pointer == nullptr) ? nullptr : &to[pointer - from.data()];
+}
+
+static void copyWorld() {
+	simBodies = data::bodies;
+	for (structs::CelestialBody& body : simBodies) {
+		body.parent = retarget(body.parent, data::bodies, simBodies);
+		for (structs::CelestialBody*& child : body.children) {child = retarget(child, data::bodies, simBodies);}
+	}
+
+	simRoutes = data::routes;
+	for (structs::Route& route : simRoutes) {
+		for (structs::CelestialBody*& location : route.locations) {location = retarget(location, data::bodies, simBodies);}
+	}
+
+	simShips = data::spacecraft;
+	for (structs::SpaceCraft& ship : simShips) {
+		ship.route = retarget(ship.route, data::routes, simRoutes);
+		ship.journey.startBody = retarget(ship.journey.startBody, data::bodies, simBodies);
+		ship.journey.endBody = retarget(ship.journey.endBody, data::bodies, simBodies);
+	}
+}
+
+
+static inline uint64_t digest(uint64_t hash, const void* data, size_t size) {
+	//FNV-1a over the raw bytes.
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t index=0; index<size; index++) {hash = (hash ^ bytes[index]) * 0x100000001b3ull;}
+	return hash;
+}
+
+static uint64_t digest(const simulation::Snapshot& snapshot) {
+	uint64_t hash = 0xcbf29ce484222325ull;
+	hash = digest(hash, &snapshot.UTC, sizeof(snapshot.UTC));
+	hash = digest(hash, snapshot.bodyPositions.data(), snapshot.bodyPositions.size() * sizeof(glm::ivec2));
+	hash = digest(hash, snapshot.shipPositions.data(), snapshot.shipPositions.size() * sizeof(glm::ivec2));
+	hash = digest(hash, snapshot.shipProgress.data(), snapshot.shipProgress.size() * sizeof(float));
+	return digest(hash, snapshot.shipETA.data(), snapshot.shipETA.size() * sizeof(time_t));
+}
+
+
+static void tick(unsigned long long tickNumber) {
+	bool replaying = journal::replaying();
+	time_t UTC = (replaying) ? journal::replayTime() : utils::getTimestamp();
+	bodies::evaluate(UTC, simBodies);
+	spacecraft::evaluate(UTC, simShips);
+	if (replaying) {
+		journal::replay(simShips); //Journaled positions, corrections included.
+	} else {
+		telemetry::apply(UTC, simShips); //Reported positions override the prediction.
+		broadcast::apply(simBodies, simShips); //Connected to a server; Its positions replace the local ones.
+		journal::record(UTC, simShips);
+	}
+	schedule::advance(UTC, simBodies, simShips); //Leg events due by now, into the arrivals & departures boards.
+
+	//Sized on the first use of each slot, no allocation after that.
+	simulation::Snapshot& snapshot = snapshots.back();
+	snapshot.UTC = UTC;
+	snapshot.tick = tickNumber;
+	snapshot.bodyPositions.resize(simBodies.size());
+	for (size_t index=0; index<simBodies.size(); index++) {snapshot.bodyPositions[index] = simBodies[index].position;}
+	snapshot.shipPositions.resize(simShips.size());
+	snapshot.shipProgress.resize(simShips.size());
+	snapshot.shipETA.resize(simShips.size());
+	for (size_t index=0; index<simShips.size(); index++) {
+		snapshot.shipPositions[index] = simShips[index].position;
+		snapshot.shipProgress[index] = simShips[index].journey.progress;
+		snapshot.shipETA[index] = simShips[index].journey.ETA;
+	}
+	broadcast::publish(snapshot); //Serving; Queued for every client, never waits.
+	heatmap::accumulate(snapshot.bodyPositions, snapshot.shipPositions); //When asked for; Packed positions, rather than the ships.
+	uint64_t hash = digest(snapshot);
+	snapshots.publish();
+	published = tickNumber;
+	if (hash != publishedDigest) {
+		publishedDigest = hash;
+		redraw::wake(redraw::RR_SIMULATION);
+	}
+}
+
+
+static void run() {
+	Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0d / sim::SIM_HZ));
+	Clock::time_point deadline = Clock::now();
+	unsigned long long tickNumber = 0u;
+	profiler::nameThread("Simulation");
+	while (simRunning) {
+		{PROFILE_SCOPE("Tick"); tick(++tickNumber);}
+		deadline += period;
+		Clock::time_point now = Clock::now();
+		if (now > deadline) {deadline = now; /* Overran, do not try to catch up. */}
+		std::this_thread::sleep_until(deadline);
+	}
+}
+
+
+
+
+namespace simulation {
+
+void start() {
+	if (simRunning) {return;}
+	copyWorld();
+	simRunning = true;
+	simThread = std::thread(run);
+}
+
+
+void stop() {
+	if (!simRunning) {return;}
+	simRunning = false;
+	simThread.join();
+}
+
+
+bool running() {
+	return simRunning;
+}
+
+
+
+time_t apply() {
+	snapshots.acquire();
+	const Snapshot& snapshot = snapshots.front();
+	if (snapshot.tick == 0u) {return utils::getTimestamp(); /* Nothing published yet, data:: is still as loaded. */}
+
+	for (size_t index=0; index<snapshot.bodyPositions.size(); index++) {data::bodies[index].position = snapshot.bodyPositions[index];}
+	for (size_t index=0; index<snapshot.shipPositions.size(); index++) {
+		structs::SpaceCraft& ship = data::spacecraft[index];
+		ship.position = snapshot.shipPositions[index];
+		ship.journey.progress = snapshot.shipProgress[index];
+		ship.journey.ETA = snapshot.shipETA[index];
+	}
+	return snapshot.UTC;
+}
+
+
+unsigned long long ticks() {
+	return published;
+}
+
+}
@@ -0,0 +1,35 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "includes.h"
+#include "constants.h"
+
+
+
+
+namespace simulation {
+
+	//Immutable once published. Indices match data::bodies & data::spacecraft.
+	struct Snapshot {
+		time_t UTC = 0;					//Scaled UTC it was evaluated at.
+		unsigned long long tick = 0u;	//0 until the first publish.
+		std::vector<glm::ivec2> bodyPositions;
+		std::vector<glm::ivec2> shipPositions;
+		std::vector<float> shipProgress;
+		std::vector<time_t> shipETA;
+	};
+
+
+	//Simulation thread; Evaluates its own copy of the bodies & ships at sim::SIM_HZ, independent of the frame rate.
+	void start(); //Call after loading.
+	void stop();
+	bool running();
+
+	//Render thread; Copy the newest snapshot into data::bodies & data::spacecraft. Returns its UTC.
+	time_t apply();
+	unsigned long long ticks(); //Snapshots published so far.
+
+}
+
+
+#endif
@@ -0,0 +1,126 @@
+#include "includes.h"
+#include "sockets.h"
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+
+
+#ifdef __linux__
+static socklen_t socketAddress(const sockets::Endpoint& endpoint, bool loopbackOnly, sockaddr_storage& address) {
+	//0 if the host could not be resolved.
+	std::memset(&address, 0, sizeof(address));
+	if (endpoint.unixSocket) {
+		sockaddr_un* local = reinterpret_cast<sockaddr_un*>(&address);
+		local->sun_family = AF_UNIX;
+		std::strncpy(local->sun_path, endpoint.path.c_str(), sizeof(local->sun_path) - 1u);
+		return sizeof(sockaddr_un);
+	}
+	sockaddr_in* inet = reinterpret_cast<sockaddr_in*>(&address);
+	inet->sin_family = AF_INET;
+	inet->sin_port = htons(endpoint.port);
+	inet->sin_addr.s_addr = htonl((loopbackOnly) ? INADDR_LOOPBACK : INADDR_ANY);
+	if (!endpoint.host.empty() && (::inet_pton(AF_INET, endpoint.host.c_str(), &inet->sin_addr) != 1)) {
+		addrinfo hints = {}, *found = nullptr;
+		hints.ai_family = AF_INET;
+		if ((::getaddrinfo(endpoint.host.c_str(), nullptr, &hints, &found) != 0) || !found) {return 0u;}
+		inet->sin_addr = reinterpret_cast<sockaddr_in*>(found->ai_addr)->sin_addr;
+		::freeaddrinfo(found);
+	}
+	return sizeof(sockaddr_in);
+}
+#endif
+
+
+
+
+namespace sockets {
+
+bool parse(const std::string& text, Endpoint& endpoint) {
+	endpoint.text = text;
+#ifdef __linux__
+	try {
+		if (text.rfind("unix:", 0) == 0) {
+			endpoint.unixSocket = true;
+			endpoint.path = text.substr(5);
+			return !endpoint.path.empty() && (endpoint.path.size() < sizeof(sockaddr_un::sun_path));
+		}
+		size_t prefix = ((text.rfind("udp:", 0) == 0) || (text.rfind("tcp:", 0) == 0)) ? 4u : 0u;
+		size_t colon = text.rfind(':');
+		if ((colon != std::string::npos) && (colon >= prefix)) {endpoint.host = text.substr(prefix, colon - prefix); prefix = colon + 1u;}
+		unsigned long port = std::stoul(text.substr(prefix));
+		endpoint.port = static_cast<uint16_t>(port);
+		return (port > 0u) && (port <= 65535u);
+	} catch (const std::exception&) {return false;}
+#else
+	return false;
+#endif
+}
+
+
+int listen(const Endpoint& endpoint, int type, bool loopbackOnly) {
+#ifdef __linux__
+	if (endpoint.unixSocket) {::unlink(endpoint.path.c_str()); /* Left behind by an earlier run. */}
+	int socket = ::socket((endpoint.unixSocket) ? AF_UNIX : AF_INET, type, 0);
+	if (socket >= 0) {
+		int reuse = 1;
+		::setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)); //Restart without waiting out TIME_WAIT.
+	}
+	sockaddr_storage address;
+	socklen_t addressSize = socketAddress(endpoint, loopbackOnly, address);
+	if (
+		(socket < 0) || (addressSize == 0u) ||
+		(::bind(socket, reinterpret_cast<sockaddr*>(&address), addressSize) != 0) ||
+		((type == SOCK_STREAM) && (::listen(socket, SOMAXCONN) != 0))
+	) {
+		std::cerr << "Could not listen on [" << endpoint.text << "] : " << std::strerror(errno) << std::endl;
+		if (socket >= 0) {::close(socket);}
+		return -1;
+	}
+	return socket;
+#else
+	std::cerr << "Sockets are only supported on Linux." << std::endl;
+	return -1;
+#endif
+}
+
+
+int connect(const Endpoint& endpoint, int type) {
+#ifdef __linux__
+	int socket = ::socket((endpoint.unixSocket) ? AF_UNIX : AF_INET, type, 0);
+	sockaddr_storage address;
+	socklen_t addressSize = socketAddress(endpoint, true, address);
+	if ((socket < 0) || (addressSize == 0u) || (::connect(socket, reinterpret_cast<sockaddr*>(&address), addressSize) != 0)) {
+		std::cerr << "Could not connect to [" << endpoint.text << "] : " << std::strerror(errno) << std::endl;
+		if (socket >= 0) {::close(socket);}
+		return -1;
+	}
+	return socket;
+#else
+	std::cerr << "Sockets are only supported on Linux." << std::endl;
+	return -1;
+#endif
+}
+
+
+void close(int socket) {
+#ifdef __linux__
+	if (socket >= 0) {::close(socket);}
+#endif
+}
+
+void close(int socket, const Endpoint& endpoint) {
+#ifdef __linux__
+	if (socket < 0) {return;}
+	::close(socket);
+	if (endpoint.unixSocket) {::unlink(endpoint.path.c_str());}
+#endif
+}
+
+}
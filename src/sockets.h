@@ -0,0 +1,33 @@
+#ifndef SOCKETS_H
+#define SOCKETS_H
+
+#include "includes.h"
+
+
+
+
+namespace sockets {
+
+	//"udp:[host:]<port>" / "tcp:[host:]<port>" (the prefix is only a hint, the caller picks the type), "unix:<path>", or just a port.
+	//The host defaults to localhost; Every interface takes an explicit host, e.g. "tcp:0.0.0.0:<port>". Linux only.
+	struct Endpoint {
+		bool unixSocket = false;
+		std::string host;
+		uint16_t port = 0u;
+		std::string path;
+		std::string text;
+	};
+
+	bool parse(const std::string& text, Endpoint& endpoint);
+
+	//Both return -1 on failure, after reporting it. type is SOCK_DGRAM or SOCK_STREAM.
+	int listen(const Endpoint& endpoint, int type, bool loopbackOnly); //Bound, and listening for a stream. Without a host; Loopback only, or every interface.
+	int connect(const Endpoint& endpoint, int type);
+
+	void close(int socket);
+	void close(int socket, const Endpoint& endpoint); //Listening socket, also removes a Unix socket's file.
+
+}
+
+
+#endif
@@ -0,0 +1,98 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "streaming.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+glBufferSubData on a buffer the GPU may still be reading forces the driver to either
+stall or copy. Instead, each StreamBuffer is one immutable allocation;
+ - Mapped once with GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT, never unmapped.
+ - Split into STREAM_REGION_COUNT regions. map() fences the region in use (covering
+   every command submitted while it was bound), moves on to the next region, and
+   waits on that region's fence; Normally signalled long ago.
+ - Writes go straight into mapped memory, with no allocation and no implicit sync.
+\* -------------------------------------------------------------------------------- */
+
+
+static size_t offsetAlignment(GLenum target) {
+	GLint alignment = 1;
+	if (target == GL_SHADER_STORAGE_BUFFER) {glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);}
+	else if (target == GL_UNIFORM_BUFFER) {glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);}
+	return static_cast<size_t>(std::max(alignment, 16)); //16 keeps vec4s aligned for every other use.
+}
+
+
+
+
+namespace streaming {
+
+void StreamBuffer::create(GLenum bufferTarget, size_t size, GLint bindingPoint) {
+	destroy();
+	target = bufferTarget;
+	binding = bindingPoint;
+	regionBytes = std::max(size, size_t(1u));
+	size_t alignment = offsetAlignment(target);
+	regionStride = ((regionBytes + alignment - 1u) / alignment) * alignment;
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &ID);
+	glBindBuffer(target, ID);
+	glBufferStorage(target, regionStride * fences.size(), nullptr, flags);
+	mapped = static_cast<unsigned char*>(glMapBufferRange(target, 0, regionStride * fences.size(), flags));
+	glBindBuffer(target, 0);
+	if (!mapped) {utils::raise("Failed to map a streaming buffer. [Needs OpenGL 4.4+]");}
+
+	region = 0u;
+	started = false;
+	stallCount = 0u;
+}
+
+
+void StreamBuffer::destroy() {
+	for (GLsync& fence : fences) {
+		if (fence) {glDeleteSync(fence); fence = nullptr;}
+	}
+	if (ID) {
+		glBindBuffer(target, ID);
+		glUnmapBuffer(target);
+		glBindBuffer(target, 0);
+		glDeleteBuffers(1, &ID);
+	}
+	ID = 0u;
+	mapped = nullptr;
+}
+
+
+void* StreamBuffer::map() {
+	if (started) {
+		//Fence the region just used, then move on.
+		if (fences[region]) {glDeleteSync(fences[region]);}
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		region = (region + 1u) % fences.size();
+	}
+	started = true;
+
+	GLsync& fence = fences[region];
+	if (fence) {
+		GLenum status = glClientWaitSync(fence, 0, 0);
+		if ((status != GL_ALREADY_SIGNALED) && (status != GL_CONDITION_SATISFIED)) {
+			stallCount++; //GPU is a whole ring behind, nothing else to do but wait.
+			while (((status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000u)) == GL_TIMEOUT_EXPIRED)) {}
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+	return mapped + offset();
+}
+
+
+void StreamBuffer::commit() {
+	//Coherent, so nothing to flush.
+	if (binding >= 0) {glBindBufferRange(target, binding, ID, offset(), regionBytes);}
+}
+
+}
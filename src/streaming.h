@@ -0,0 +1,58 @@
+#ifndef STREAMING_H
+#define STREAMING_H
+
+#include "includes.h"
+#include "constants.h"
+
+
+
+
+namespace streaming {
+
+	//Persistently mapped buffer, split into display::STREAM_REGION_COUNT regions used in turn.
+	//Each region is fenced once the frame using it is submitted, so writing to it never stalls against the GPU.
+	//The owner calls destroy() while the context is current; The destructor frees nothing, as static destruction runs after the context is gone.
+	class StreamBuffer {
+	public:
+		StreamBuffer() = default;
+		~StreamBuffer() = default;
+		StreamBuffer(const StreamBuffer&) = delete;
+		StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+		void create(GLenum target, size_t regionSize, GLint binding=-1); //Binding <0 is never bound, e.g. a copy source.
+		void destroy();
+
+		void* map(); //Next region to write. Only waits if the GPU is STREAM_REGION_COUNT frames behind.
+		template<typename T> T* map() {return static_cast<T*>(map());}
+		void commit(); //Bind the region just written to the binding point (if any). Call before the draws which read it.
+
+		//Convert straight into the next region, without a temporary. [TGPU(TCPU) constructor]
+		template<typename TGPU, typename TCPU>
+		void upload(const std::vector<TCPU>& dataSet) {
+			TGPU* destination = map<TGPU>();
+			size_t count = std::min(dataSet.size(), regionBytes / sizeof(TGPU));
+			for (size_t index=0; index<count; index++) {new (destination + index) TGPU(dataSet[index]);}
+			commit();
+		}
+
+		GLuint buffer() const {return ID;}
+		GLintptr offset() const {return static_cast<GLintptr>(region) * regionStride;} //Of the current region.
+		size_t regionSize() const {return regionBytes;}
+		size_t stalls() const {return stallCount;} //Times map() had to wait on the GPU.
+
+	private:
+		GLuint ID = 0u;
+		GLenum target = GL_SHADER_STORAGE_BUFFER;
+		GLint binding = -1;
+		size_t regionBytes = 0u, regionStride = 0u; //Stride is rounded up to the offset alignment.
+		unsigned char* mapped = nullptr;
+		std::array<GLsync, display::STREAM_REGION_COUNT> fences = {};
+		unsigned int region = 0u;
+		bool started = false;
+		size_t stallCount = 0u;
+	};
+
+}
+
+
+#endif
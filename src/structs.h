@@ -0,0 +1,163 @@
+#ifndef STRUCTS_H
+#define STRUCTS_H
+
+#include "coreincludes.h"
+#include "constants.h"
+#include "phase.h"
+
+
+//Simulation types & data, shared by the core library and the app. No graphics. [See core.h]
+
+
+inline unsigned int simSpeed = 1u; //Sim time multiplier, from the data file.
+
+
+
+enum CelestialType {
+	CT_INVALID,   //Not a valid type.
+	CT_STAR,      //Anything stationary.
+	CT_PLANET,    //Anything orbiting a star.
+	CT_SATELLITE, //Moons, Stations, anything orbiting a planet.
+	CT_GATE       //Gates to other stars. Transports ships "instantly" (like teleporting but better)
+};
+
+
+namespace structs {
+
+
+//Star/Planet/Satellite
+struct CelestialBody {
+	std::string name;    	//Body name.
+	CelestialType type;		//What sort of body?
+	glm::ivec2 position;  	//Current position.
+	unsigned int radius;	//Radius of the body.
+	glm::vec3 colour;		//Colour of its orbital line.
+
+	bool hasParentBody;		//Should orbit around some parent body?
+	CelestialBody* parent;	//Star to orbit around.
+	float orbitalRadius; 	//Distance from centre to orbit.
+	float orbitalPeriod; 	//Time for 1 orbit.
+	uint64_t phaseStep;		//Q32.32 turns per sim second, from the period. [See phase.h]
+	float progress;			//0-1 of orbit completed.
+
+	std::vector<CelestialBody*> children; //Child bodies.
+
+	CelestialBody()
+		 : name("<BODY_INVALID>"), type(CT_INVALID), position(0.0f, 0.0f), colour(0.0f, 0.0f, 0.0f),
+		   radius(0.0f), hasParentBody(false), parent(nullptr), orbitalRadius(0.0f), orbitalPeriod(0.0f), phaseStep(0u), children() {}
+	CelestialBody(std::string n, CelestialType t, glm::vec2 pos, glm::vec3 c, unsigned int bR, float oR, float p, CelestialBody* parent=nullptr)
+		 : name(n), type(t), position(pos), colour(c), radius(bR), hasParentBody(parent != nullptr), parent(parent), orbitalRadius(oR), orbitalPeriod(p), phaseStep(phase::step(p)), children() {}
+};
+
+
+//Static route information.
+struct Route {
+	std::string number; 					//E.g. "BTN-7274"
+	std::vector<CelestialBody*> locations;  //List of places to go.
+	std::vector<time_t> legDurations;		//Flight time from each location to the next, in sim seconds.
+	time_t period;							//Time to fly the whole route once.
+
+	Route() : number("<ROUTE_INVALID>"), locations(), legDurations(), period(0) {}
+	Route(std::string n, std::vector<CelestialBody*> l)
+		 : number(n), locations(l), legDurations(), period(0) {}
+};
+
+
+//Contains flight data.
+struct Flight {
+	CelestialBody* startBody;	//Start
+	glm::ivec2 startPos; 		//Where was the start when the journey began?
+	CelestialBody* endBody;		//Destination
+	glm::ivec2 endPos;			//Where will it intercept the destination?
+	time_t ETA; 				//UTC ETA, scaled. 64 bit; Scaled time passes 2^32 at simSpeed 3.
+	float progress;     		//0-1 of journey completed. Based on time, NOT distance.
+	unsigned int leg;			//Index of startBody in the route's locations.
+	std::string number; 		//E.g. "BTN-7274"
+
+	Flight() : startBody(nullptr), endBody(nullptr), leg(0u), number("<FLIGHT_INVALID>") {}
+	Flight(CelestialBody* s, CelestialBody* e, std::string n)
+		 : startBody(s), endBody(e), leg(0u), number(n) {}
+};
+
+
+//A single spacecraft.
+struct SpaceCraft {
+	std::string name;    //Spacecraft name.
+	Flight journey;      //Current journey.
+	Route* route;	     //The route it follows.
+	float speed;	     //Current speed.
+	glm::ivec2 position; //Current position.
+
+	SpaceCraft() : name("<SHIP_INVALID>"), journey(), route(nullptr), speed(0.0f) {}
+	SpaceCraft(std::string n, Route* r)
+		 : name(n), journey(), route(r), speed(0.0f) {}
+
+	float& getSpeed() {
+		glm::ivec2 delta = this->journey.endPos - this->journey.startPos;
+		float distance = sqrt((delta.x*delta.x) + (delta.y+delta.y)); //glm::length doesn't accept ivec for some reason.
+		float progress = this->journey.progress;
+		if (progress < 0.5f) {
+			//Accelerating
+			this->speed = sim::SHIP_Gs * progress * distance;
+		} else {
+			//Deccelerating
+			this->speed = (distance * sim::SHIP_Gs) * (1.0f - progress);
+		}
+		return this->speed;
+	}
+
+	glm::ivec2& getPosition() {
+		//Calculate current position given the progress through the journey.
+		return this->position;
+	}
+};
+
+
+
+//Camera view (Scale, Body to centre on)
+struct CameraView {
+	std::string name;		  //Name or short identified for the view.
+	CelestialBody* focusBody; //Body to centre view on.
+	float scale;			  //Scaling of distances.
+	glm::ivec2 offset;        //Camera offset from the body.
+
+	CameraView() : name("<VIEW_INVALID>"), focusBody(nullptr), scale(0.0f), offset(0, 0) {}
+	CameraView(std::string n, CelestialBody* cb, float s, glm::ivec2 o)
+		 : name(n), focusBody(cb), scale(s), offset(o) {}
+};
+
+
+//One scripted step of a headless benchmark (View, time to evaluate at)
+struct BenchmarkStep {
+	CameraView* view;		//View to render.
+	time_t time;			//Scaled UTC time of the first frame.
+	time_t timeStep;		//Sim seconds added every frame.
+	unsigned int frames;	//Measured frames.
+	unsigned int warmup;	//Unmeasured frames rendered first.
+
+	BenchmarkStep() : view(nullptr), time(0), timeStep(0), frames(0u), warmup(0u) {}
+	BenchmarkStep(CameraView* v, time_t t, time_t dt, unsigned int f, unsigned int w)
+		 : view(v), time(t), timeStep(dt), frames(f), warmup(w) {}
+};
+
+}
+
+
+
+//All sim data.
+namespace data {
+	inline std::vector<structs::CelestialBody> bodies = {};
+	inline std::vector<structs::Route> routes = {};
+	inline std::vector<structs::SpaceCraft> spacecraft = {};
+
+	inline unsigned int currentCameraViewIndex = 0u;
+	inline std::vector<structs::CameraView> views = {};
+	inline structs::CameraView* view = nullptr;
+
+	//From the data file's <meta>, applied by whatever uses them.
+	inline unsigned int trailLength = display::TRAIL_LENGTH;
+	inline float trailFade = display::TRAIL_FADE;
+}
+
+
+#endif
@@ -0,0 +1,264 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "threading.h"
+#include "profiler.h"
+#include "sockets.h"
+#include "core.h"
+#include "telemetry.h"
+#ifdef __linux__
+#include <sys/socket.h>
+#endif
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Socket -> I/O thread (parse) -> MPSCQueue<Update> -> simulation thread (apply)
+ - Each endpoint has its own I/O thread, reading datagrams in batches (recvmmsg) and
+   pushing every message into one shared lock-free queue. If the simulation falls so far
+   behind the queue fills, updates are dropped (and counted) rather than blocking the socket.
+ - The simulation drains the queue once per tick, keeping only the newest report per ship.
+   A report replaces that ship's predicted position; the offset to the prediction then
+   fades out over sim::TELEMETRY_BLEND_TIME, so a ship slides back onto its plan when the
+   feed goes quiet instead of jumping.
+Linux only.
+\* -------------------------------------------------------------------------------- */
+
+
+constexpr unsigned int RECEIVE_BATCH = 32u; //Datagrams per recvmmsg().
+constexpr size_t DATAGRAM_SIZE = 65536u;
+constexpr unsigned int GENERATOR_MESSAGES = 64u; //Per datagram, 1.3KB.
+constexpr unsigned int GENERATOR_BATCH = 16u; //Datagrams per sendmmsg().
+
+
+struct Listener {
+	int socket = -1;
+	sockets::Endpoint endpoint;
+	std::thread thread;
+};
+
+struct Correction {
+	glm::ivec2 reported = glm::ivec2(0, 0), offset = glm::ivec2(0, 0);
+	time_t reportUTC = 0;
+	bool active = false, fresh = false;
+};
+
+
+static threading::MPSCQueue<telemetry::Update> updates(sim::TELEMETRY_QUEUE_CAPACITY);
+static std::vector<std::unique_ptr<Listener>> listeners;
+static std::atomic<bool> stopping = false;
+static std::atomic<uint64_t> received = 0u, dropped = 0u, malformed = 0u, applied = 0u;
+static std::vector<Correction> corrections; //Simulation thread only.
+
+
+
+static void parse(const unsigned char* data, size_t size) {
+	//I/O thread.
+	uint16_t version, count;
+	if (size < telemetry::HEADER_SIZE) {malformed++; return;}
+	std::memcpy(&version, data + 4u, sizeof(version));
+	std::memcpy(&count, data + 6u, sizeof(count));
+	if (
+		(std::memcmp(data, "SBTM", 4u) != 0) || (version != 1u) ||
+		(size < telemetry::HEADER_SIZE + (static_cast<size_t>(count) * telemetry::MESSAGE_SIZE))
+	) {malformed++; return;}
+
+	uint64_t pushed = 0u;
+	const unsigned char* message = data + telemetry::HEADER_SIZE;
+	for (uint16_t index=0u; index<count; index++, message+=telemetry::MESSAGE_SIZE) {
+		telemetry::Update update;
+		int64_t UTC;
+		std::memcpy(&update.ship, message, 4u);
+		std::memcpy(&update.position.x, message + 4u, 4u);
+		std::memcpy(&update.position.y, message + 8u, 4u);
+		std::memcpy(&UTC, message + 12u, 8u);
+		update.UTC = static_cast<time_t>(UTC);
+		if (updates.tryPush(update)) {pushed++;}
+	}
+	received += pushed;
+	dropped += count - pushed;
+}
+
+
+static void receive(Listener* listener) {
+	//I/O thread.
+	profiler::nameThread("Telemetry");
+#ifdef __linux__
+	std::vector<unsigned char> buffers(static_cast<size_t>(RECEIVE_BATCH) * DATAGRAM_SIZE);
+	std::array<iovec, RECEIVE_BATCH> vectors;
+	std::array<mmsghdr, RECEIVE_BATCH> headers;
+	for (unsigned int index=0u; index<RECEIVE_BATCH; index++) {
+		vectors[index] = {buffers.data() + (index * DATAGRAM_SIZE), DATAGRAM_SIZE};
+		headers[index] = {};
+		headers[index].msg_hdr.msg_iov = &vectors[index];
+		headers[index].msg_hdr.msg_iovlen = 1u;
+	}
+
+	while (!stopping) {
+		//Returns once at least one datagram is in, or after the receive timeout so stopping is noticed.
+		int count = recvmmsg(listener->socket, headers.data(), RECEIVE_BATCH, MSG_WAITFORONE, nullptr);
+		for (int index=0; index<count; index++) {
+			parse(buffers.data() + (index * DATAGRAM_SIZE), headers[index].msg_len);
+		}
+	}
+#endif
+}
+
+
+
+
+namespace telemetry {
+
+bool listen(const std::string& endpointText) {
+#ifdef __linux__
+	std::unique_ptr<Listener> listener = std::make_unique<Listener>();
+	if (!sockets::parse(endpointText, listener->endpoint)) {
+		std::cerr << "Invalid telemetry endpoint [" << endpointText << "] : Expected udp:<port>, unix:<path> or a port." << std::endl;
+		return false;
+	}
+	listener->socket = sockets::listen(listener->endpoint, SOCK_DGRAM, true); //Local feed only.
+	if (listener->socket < 0) {return false;}
+	int bufferSize = 16 << 20; //Absorbs bursts while the I/O thread is descheduled. Capped by net.core.rmem_max.
+	::setsockopt(listener->socket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+	timeval timeout = {0, 100000}; //100ms
+	::setsockopt(listener->socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	stopping = false;
+	listener->thread = std::thread(receive, listener.get());
+	std::cout << "Listening for telemetry on [" << endpointText << "]" << std::endl;
+	listeners.push_back(std::move(listener));
+	return true;
+#else
+	std::cerr << "Telemetry is only supported on Linux." << std::endl;
+	return false;
+#endif
+}
+
+
+void stop() {
+	if (listeners.empty()) {return;}
+	stopping = true;
+#ifdef __linux__
+	for (std::unique_ptr<Listener>& listener : listeners) {
+		listener->thread.join();
+		sockets::close(listener->socket, listener->endpoint);
+	}
+#endif
+	listeners.clear();
+	Stats s = stats();
+	std::cout << "Telemetry stopped : " << s.received << " updates received, " << s.applied << " applied, " << s.dropped << " dropped, " << s.malformed << " malformed datagrams." << std::endl;
+}
+
+
+bool listening() {
+	return !listeners.empty();
+}
+
+
+Stats stats() {
+	return {received.load(), dropped.load(), malformed.load(), applied.load()};
+}
+
+
+
+void apply(time_t UTC, std::vector<structs::SpaceCraft>& ships) {
+	if (corrections.size() != ships.size()) {corrections.resize(ships.size());}
+
+	//Newest report per ship. Older ones arriving late are ignored.
+	Update update;
+	uint64_t taken = 0u;
+	while (updates.tryPop(update)) {
+		taken++;
+		if (update.ship >= ships.size()) {continue;}
+		Correction& correction = corrections[update.ship];
+		if (correction.active && (update.UTC < correction.reportUTC)) {continue;}
+		correction.reported = update.position;
+		correction.reportUTC = update.UTC;
+		correction.active = correction.fresh = true;
+	}
+	applied += taken;
+
+	for (size_t index=0; index<ships.size(); index++) {
+		Correction& correction = corrections[index];
+		if (!correction.active) {continue;}
+		if (correction.fresh) {
+			correction.offset = correction.reported - ships[index].position; //Against the prediction just evaluated.
+			correction.fresh = false;
+		}
+		double age = static_cast<double>(std::max<time_t>(UTC - correction.reportUTC, 0));
+		double weight = 1.0d - (age / static_cast<double>(sim::TELEMETRY_BLEND_TIME));
+		if (weight <= 0.0d) {correction.active = false; continue; /* Back on the plan. */}
+		ships[index].position += glm::ivec2(glm::dvec2(correction.offset) * weight);
+	}
+}
+
+
+
+void generate(const std::string& endpointText, double rate, double seconds, uint32_t shipCount) {
+#ifdef __linux__
+	sockets::Endpoint endpoint;
+	if (!sockets::parse(endpointText, endpoint)) {
+		std::cerr << "Invalid telemetry endpoint [" << endpointText << "]" << std::endl;
+		return;
+	}
+	int generatorSocket = sockets::connect(endpoint, SOCK_DGRAM);
+	if (generatorSocket < 0) {return;}
+	shipCount = std::max(shipCount, 1u);
+
+	size_t datagramSize = HEADER_SIZE + (GENERATOR_MESSAGES * MESSAGE_SIZE);
+	std::vector<unsigned char> buffers(GENERATOR_BATCH * datagramSize);
+	std::array<iovec, GENERATOR_BATCH> vectors;
+	std::array<mmsghdr, GENERATOR_BATCH> headers;
+	uint16_t version = 1u, count = GENERATOR_MESSAGES;
+	for (unsigned int index=0u; index<GENERATOR_BATCH; index++) {
+		unsigned char* datagram = buffers.data() + (index * datagramSize);
+		std::memcpy(datagram, "SBTM", 4u);
+		std::memcpy(datagram + 4u, &version, 2u);
+		std::memcpy(datagram + 6u, &count, 2u);
+		vectors[index] = {datagram, datagramSize};
+		headers[index] = {};
+		headers[index].msg_hdr.msg_iov = &vectors[index];
+		headers[index].msg_hdr.msg_iovlen = 1u;
+	}
+
+	//Each ship circles its planned position (data::spacecraft, re-evaluated after the bodies once per sim second) a little, so corrections are visible.
+	uint64_t sent = 0u, failed = 0u, messageIndex = 0u;
+	int64_t evaluatedUTC = std::numeric_limits<int64_t>::min();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	double elapsed = 0.0d;
+	std::cout << "Sending telemetry to [" << endpointText << "] : " << rate << " updates/s for " << seconds << "s." << std::endl;
+	while (elapsed < seconds) {
+		int64_t UTC = static_cast<int64_t>(utils::getTimestamp());
+		if (UTC != evaluatedUTC) {core::evaluate(static_cast<time_t>(UTC)); evaluatedUTC = UTC;}
+		for (unsigned int datagramIndex=0u; datagramIndex<GENERATOR_BATCH; datagramIndex++) {
+			unsigned char* message = buffers.data() + (datagramIndex * datagramSize) + HEADER_SIZE;
+			for (unsigned int index=0u; index<GENERATOR_MESSAGES; index++, message+=MESSAGE_SIZE, messageIndex++) {
+				uint32_t ship = static_cast<uint32_t>(messageIndex % shipCount);
+				double angle = (UTC + ship) * 1.0e-2d;
+				glm::ivec2 planned = (ship < data::spacecraft.size()) ? data::spacecraft[ship].position : glm::ivec2(0, 0);
+				glm::ivec2 position = planned + glm::ivec2(glm::dvec2(std::cos(angle), std::sin(angle)) * 1.0e5d);
+				std::memcpy(message, &ship, 4u);
+				std::memcpy(message + 4u, &position.x, 4u);
+				std::memcpy(message + 8u, &position.y, 4u);
+				std::memcpy(message + 12u, &UTC, 8u);
+			}
+		}
+		int count = sendmmsg(generatorSocket, headers.data(), GENERATOR_BATCH, 0);
+		if (count > 0) {sent += static_cast<uint64_t>(count) * GENERATOR_MESSAGES;}
+		if (count < static_cast<int>(GENERATOR_BATCH)) {failed += (GENERATOR_BATCH - std::max(count, 0)) * GENERATOR_MESSAGES;}
+
+		//Paced to the rate; sleeps while ahead.
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		double ahead = ((sent + failed) / rate) - elapsed;
+		if (ahead > 0.0d) {std::this_thread::sleep_for(std::chrono::duration<double>(ahead));}
+	}
+	sockets::close(generatorSocket);
+	std::cout << "Sent " << sent << " updates in " << elapsed << "s (" << static_cast<uint64_t>(sent / elapsed) << "/s), " << failed << " failed." << std::endl;
+#else
+	std::cerr << "Telemetry is only supported on Linux." << std::endl;
+#endif
+}
+
+}
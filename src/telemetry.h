@@ -0,0 +1,49 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "includes.h"
+#include "constants.h"
+#include "global.h"
+
+
+
+
+namespace telemetry {
+
+	//Wire format, little endian. One datagram holds a header, then header.count messages;
+	//  Header  : "SBTM", uint16 version (1), uint16 count.
+	//  Message : uint32 ship (index into data::spacecraft), int32 x, int32 y, int64 UTC (scaled, as positions are evaluated at).
+	constexpr size_t HEADER_SIZE = 8u, MESSAGE_SIZE = 20u;
+
+	struct Update {
+		uint32_t ship;
+		glm::ivec2 position;
+		time_t UTC;
+	};
+
+	struct Stats {
+		uint64_t received = 0u;  //Messages parsed.
+		uint64_t dropped = 0u;   //Queue full, the simulation is behind.
+		uint64_t malformed = 0u; //Datagrams ignored.
+		uint64_t applied = 0u;   //Messages taken by the simulation.
+	};
+
+
+	//I/O thread per endpoint, all feeding one queue. "udp:<port>" (localhost), "unix:<path>" (datagram socket), or just a port.
+	bool listen(const std::string& endpoint);
+	void stop(); //Every listener.
+	bool listening();
+	Stats stats();
+
+	//Simulation thread; Take every queued update, then correct the predicted positions. Reports override the prediction,
+	//and the correction fades out over sim::TELEMETRY_BLEND_TIME once they stop.
+	void apply(time_t UTC, std::vector<structs::SpaceCraft>& ships);
+
+	//Stands in for the real feed; Sends rate messages per second for a number of ships, until seconds have passed.
+	//Each report is a small circle around the ship's planned position in data::spacecraft, so it reads as a correction.
+	void generate(const std::string& endpoint, double rate, double seconds, uint32_t shipCount);
+
+}
+
+
+#endif
@@ -0,0 +1,271 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "streaming.h"
+#include "text.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Labels, for thousands of bodies & ships in one draw;
+ - Glyphs come from a built-in 5x7 font, packed once into a small R8 atlas.
+ - Each label's glyph offsets are cached by key, and only rebuilt when its text changes.
+ - build() sorts the frame's labels by priority and places each one only if the
+   screen-space grid cells it covers are still free (decluttering), then writes its
+   glyphs straight into a streaming buffer (bindings::LABEL_GLYPHS).
+ - frame::labels() draws every glyph as one instanced quad.
+\* -------------------------------------------------------------------------------- */
+
+
+//ASCII 32-95, 7 rows of 5 bits each, top row first. Lower case is drawn as upper case.
+static const unsigned char FONT_5x7[64][7] = {
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, //' '
+	{0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04}, //'!'
+	{0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00}, //'"'
+	{0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A}, //'#'
+	{0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04}, //'$'
+	{0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}, //'%'
+	{0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D}, //'&'
+	{0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00}, //'''
+	{0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}, //'('
+	{0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}, //')'
+	{0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00}, //'*'
+	{0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}, //'+'
+	{0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08}, //','
+	{0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, //'-'
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, //'.'
+	{0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, //'/'
+	{0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, //'0'
+	{0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, //'1'
+	{0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, //'2'
+	{0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, //'3'
+	{0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, //'4'
+	{0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, //'5'
+	{0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, //'6'
+	{0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, //'7'
+	{0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, //'8'
+	{0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, //'9'
+	{0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, //':'
+	{0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08}, //';'
+	{0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02}, //'<'
+	{0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00}, //'='
+	{0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08}, //'>'
+	{0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04}, //'?'
+	{0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E}, //'@'
+	{0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, //'A'
+	{0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, //'B'
+	{0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, //'C'
+	{0x1E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1E}, //'D'
+	{0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, //'E'
+	{0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, //'F'
+	{0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, //'G'
+	{0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, //'H'
+	{0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, //'I'
+	{0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, //'J'
+	{0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, //'K'
+	{0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, //'L'
+	{0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, //'M'
+	{0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, //'N'
+	{0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, //'O'
+	{0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, //'P'
+	{0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, //'Q'
+	{0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, //'R'
+	{0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, //'S'
+	{0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, //'T'
+	{0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, //'U'
+	{0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, //'V'
+	{0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, //'W'
+	{0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, //'X'
+	{0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04}, //'Y'
+	{0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, //'Z'
+	{0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E}, //'['
+	{0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00}, //'\'
+	{0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E}, //']'
+	{0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00}, //'^'
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F}, //'_'
+};
+#define GLYPH_WIDTH 5
+#define GLYPH_HEIGHT 7
+#define ATLAS_CELL 8
+#define ATLAS_COLUMNS 16
+
+
+struct LabelLayout {
+	std::string text; //Lines joined by '\n', to detect changes.
+	std::vector<std::pair<glm::ivec2, GLuint>> glyphs; //Offset from the top left, atlas cell.
+	glm::ivec2 size = glm::ivec2(0, 0);
+};
+
+struct Label {
+	const LabelLayout* layout;
+	glm::ivec2 anchor;
+	GLuint colour;
+	unsigned int priority;
+	int area; //Index into areas, -1 for the whole render.
+};
+
+static std::unordered_map<uint64_t, LabelLayout> layouts;
+static std::vector<Label> labels; //This frame's, reused.
+static std::vector<std::pair<glm::ivec2, glm::ivec2>> areas; //Minimum, maximum.
+static std::vector<unsigned int> grid; //Frame stamp of the last label in each cell.
+static unsigned int gridStamp = 0u;
+static streaming::StreamBuffer glyphStream;
+
+
+
+static inline GLuint glyphIndex(char character) {
+	unsigned char c = static_cast<unsigned char>(std::toupper(static_cast<unsigned char>(character)));
+	return ((c < 32u) || (c >= 96u)) ? static_cast<GLuint>('?' - 32) : static_cast<GLuint>(c - 32u);
+}
+
+static inline GLuint packColour(glm::vec3 colour) {
+	glm::uvec3 c = glm::uvec3((glm::clamp(colour, glm::vec3(0.0f), glm::vec3(1.0f)) * 255.0f) + 0.5f);
+	return c.x | (c.y << 8u) | (c.z << 16u) | (255u << 24u);
+}
+
+
+static bool sameText(const std::string& cached, std::initializer_list<std::string_view> lines) {
+	size_t position = 0u;
+	bool first = true;
+	for (std::string_view line : lines) {
+		if (!first) {
+			if ((position >= cached.size()) || (cached[position] != '\n')) {return false;}
+			position++;
+		}
+		if (cached.compare(position, line.size(), line) != 0) {return false;}
+		position += line.size();
+		first = false;
+	}
+	return position == cached.size();
+}
+
+static void layOut(LabelLayout& layout, std::initializer_list<std::string_view> lines) {
+	int scale = display::LABEL_SCALE;
+	int advance = (GLYPH_WIDTH + 1) * scale, lineHeight = (GLYPH_HEIGHT + 2) * scale;
+
+	layout.text.clear();
+	layout.glyphs.clear();
+	layout.size = glm::ivec2(0, 0);
+	int lineIndex = 0;
+	for (std::string_view line : lines) {
+		if (lineIndex > 0) {layout.text.push_back('\n');}
+		layout.text.append(line);
+		int x = 0;
+		for (char character : line) {
+			if (character != ' ') {layout.glyphs.push_back({glm::ivec2(x, -((lineIndex + 1) * lineHeight)), glyphIndex(character)});}
+			x += advance;
+		}
+		layout.size.x = std::max(layout.size.x, x - scale);
+		lineIndex++;
+	}
+	layout.size.y = lineIndex * lineHeight;
+}
+
+
+
+
+namespace text {
+
+void initialise() {
+	//Atlas; 16x4 cells of 8x8 texels, bottom row of each glyph at the bottom of its cell.
+	glm::ivec2 atlasSize = glm::ivec2(ATLAS_COLUMNS * ATLAS_CELL, (64 / ATLAS_COLUMNS) * ATLAS_CELL);
+	std::vector<unsigned char> atlas(atlasSize.x * atlasSize.y, 0u);
+	for (int glyph=0; glyph<64; glyph++) {
+		glm::ivec2 cell = glm::ivec2(glyph % ATLAS_COLUMNS, glyph / ATLAS_COLUMNS) * ATLAS_CELL;
+		for (int row=0; row<GLYPH_HEIGHT; row++) {
+			for (int column=0; column<GLYPH_WIDTH; column++) {
+				bool set = (FONT_5x7[glyph][row] >> (GLYPH_WIDTH - 1 - column)) & 1u;
+				atlas[((cell.y + GLYPH_HEIGHT - 1 - row) * atlasSize.x) + cell.x + column] = (set) ? 255u : 0u;
+			}
+		}
+	}
+
+	glGenTextures(1, &GLIndex::glyphAtlas);
+	glBindTexture(GL_TEXTURE_2D, GLIndex::glyphAtlas);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasSize.x, atlasSize.y, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glyphStream.create(GL_SHADER_STORAGE_BUFFER, display::LABEL_MAX_GLYPHS * sizeof(GlyphInstance), bindings::LABEL_GLYPHS);
+	labels.reserve(data::bodies.size() + data::spacecraft.size());
+}
+
+void release() {
+	glyphStream.destroy();
+}
+
+
+
+void begin() {
+	labels.clear();
+	areas.clear();
+}
+
+
+void area(glm::ivec2 origin, glm::ivec2 size) {
+	areas.push_back({origin, origin + size});
+}
+
+
+void add(uint64_t key, std::initializer_list<std::string_view> lines, glm::ivec2 anchor, glm::vec3 colour, unsigned int priority) {
+	LabelLayout& layout = layouts[key];
+	if (!sameText(layout.text, lines) || (layout.size.y == 0)) {layOut(layout, lines);}
+	labels.push_back({&layout, anchor, packColour(colour), priority, static_cast<int>(areas.size()) - 1});
+}
+
+
+GLsizei build() {
+	glm::ivec2 resolution = currentRenderResolution;
+	glm::ivec2 gridSize = (resolution + display::LABEL_GRID_CELL - 1) / display::LABEL_GRID_CELL;
+	if (grid.size() != static_cast<size_t>(gridSize.x * gridSize.y)) {grid.assign(gridSize.x * gridSize.y, 0u); gridStamp = 0u;}
+	gridStamp++; //Marks every cell free, without clearing.
+
+	std::stable_sort(labels.begin(), labels.end(), [](const Label& a, const Label& b) {return a.priority < b.priority;});
+
+	GlyphInstance* instances = glyphStream.map<GlyphInstance>();
+	GLsizei count = 0;
+	for (const Label& label : labels) {
+		const LabelLayout& layout = *label.layout;
+		glm::ivec2 topLeft = label.anchor + display::LABEL_OFFSET;
+		glm::ivec2 minimum = glm::ivec2(topLeft.x, topLeft.y - layout.size.y), maximum = glm::ivec2(topLeft.x + layout.size.x, topLeft.y);
+		if ((maximum.x < 0) || (maximum.y < 0) || (minimum.x >= resolution.x) || (minimum.y >= resolution.y)) {continue; /* Off screen. */}
+		if (label.area >= 0) {
+			const std::pair<glm::ivec2, glm::ivec2>& bounds = areas[label.area];
+			if ((minimum.x < bounds.first.x) || (minimum.y < bounds.first.y) || (maximum.x > bounds.second.x) || (maximum.y > bounds.second.y)) {continue; /* Would spill into another view. */}
+		}
+		if (count + static_cast<GLsizei>(layout.glyphs.size()) > static_cast<GLsizei>(display::LABEL_MAX_GLYPHS)) {break;}
+
+		glm::ivec2 cellMin = glm::clamp(minimum / display::LABEL_GRID_CELL, glm::ivec2(0), gridSize - 1);
+		glm::ivec2 cellMax = glm::clamp(maximum / display::LABEL_GRID_CELL, glm::ivec2(0), gridSize - 1);
+		bool free = true;
+		for (int y=cellMin.y; (y<=cellMax.y) && free; y++) {
+			for (int x=cellMin.x; x<=cellMax.x; x++) {
+				if (grid[(y * gridSize.x) + x] == gridStamp) {free = false; break;}
+			}
+		}
+		if (!free) {continue; /* Overlaps a more important label. */}
+		for (int y=cellMin.y; y<=cellMax.y; y++) {
+			for (int x=cellMin.x; x<=cellMax.x; x++) {grid[(y * gridSize.x) + x] = gridStamp;}
+		}
+
+		for (const std::pair<glm::ivec2, GLuint>& glyph : layout.glyphs) {
+			instances[count++] = {topLeft + glyph.first, glyph.second, label.colour};
+		}
+	}
+	glyphStream.commit();
+	return count;
+}
+
+
+size_t cachedLayouts() {
+	return layouts.size();
+}
+
+}
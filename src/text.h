@@ -0,0 +1,33 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include "includes.h"
+#include "constants.h"
+
+
+
+
+namespace text {
+
+	//One glyph quad. Matches "struct Glyph" in text.vert (std430, 16 bytes).
+	struct GlyphInstance {
+		glm::ivec2 position;	//Bottom left, in render pixels.
+		GLuint glyph;			//Atlas cell.
+		GLuint colour;			//RGBA8
+	};
+
+
+	void initialise(); //Build the glyph atlas and the instance stream. Call after prepareOpenGL().
+	void release(); //Free the stream, while the context is still current.
+
+	//Labels are laid out once per key, and only laid out again when their text changes.
+	void begin(); //Forget last frame's labels.
+	void area(glm::ivec2 origin, glm::ivec2 size); //Labels added after this are only kept if wholly inside it (a viewport). Reset by begin().
+	void add(uint64_t key, std::initializer_list<std::string_view> lines, glm::ivec2 anchor, glm::vec3 colour, unsigned int priority=0u); //Anchor in render pixels. Lower priority wins overlaps.
+	GLsizei build(); //Declutter, then write every visible glyph into the stream. Returns the instances to draw.
+	size_t cachedLayouts();
+
+}
+
+
+#endif
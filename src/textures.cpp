@@ -0,0 +1,265 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "threading.h"
+#include "textures.h"
+#include "profiler.h"
+#include <stb_image.h>
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Texture loading never blocks the render thread;
+ - request*() allocates the texture, fills it with the placeholder colour, and
+   queues one decode job per image on the worker pool.
+ - A job reads the decoded RGBA from the disk cache if it is still current,
+   otherwise decodes the PNG with stb_image and writes the cache for next time.
+ - update() copies finished images into a small ring of PBOs and issues the
+   glTexSubImage* from there, stopping once its per-frame time budget is spent.
+\* -------------------------------------------------------------------------------- */
+
+
+struct DecodedImage {
+	GLuint textureID;
+	int layer; //-1 for a GL_TEXTURE_2D.
+	std::string path;
+	glm::ivec2 expectedRes;
+	glm::ivec2 resolution = glm::ivec2(0, 0);
+	std::vector<unsigned char> pixels; //RGBA8. Empty if the image could not be loaded.
+};
+
+static std::mutex readyMutex;
+static std::deque<DecodedImage> ready;
+static std::atomic<size_t> inFlight = 0u; //Requested, but not yet uploaded.
+
+static std::array<GLuint, display::TEXTURE_UPLOAD_PBO_COUNT> uploadPBOs = {};
+static size_t uploadIndex = 0u;
+
+
+
+//// DISK CACHE ////
+//"saved.texturecache/<name>.rgba"; Header, then raw RGBA8. Stale once the source PNG is modified.
+struct CacheHeader {
+	char magic[4] = {'S', 'B', 'T', 'X'};
+	uint32_t version = 1u;
+	int64_t sourceTime = 0; //Source PNG last write time.
+	int32_t width = 0, height = 0;
+};
+
+static std::filesystem::path cachePath(const std::string& sourcePath) {
+	std::string name = sourcePath;
+	std::replace(name.begin(), name.end(), '/', '_');
+	std::replace(name.begin(), name.end(), '\\', '_');
+	return std::filesystem::path("saved.texturecache") / (name + ".rgba");
+}
+
+static int64_t sourceTime(const std::string& sourcePath) {
+	std::error_code error;
+	std::filesystem::file_time_type time = std::filesystem::last_write_time(sourcePath, error);
+	return (error) ? -1 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+static bool readCache(DecodedImage& image, int64_t time) {
+	std::ifstream file(cachePath(image.path), std::ios::binary);
+	if (!file) {return false;}
+
+	CacheHeader header, expected;
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (
+		!file ||
+		(std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) ||
+		(header.version != expected.version) ||
+		(header.sourceTime != time) ||
+		(header.width <= 0) || (header.height <= 0)
+	) {return false; /* Missing, old format or stale. */}
+
+	image.resolution = glm::ivec2(header.width, header.height);
+	image.pixels.resize(static_cast<size_t>(header.width) * header.height * 4u);
+	file.read(reinterpret_cast<char*>(image.pixels.data()), image.pixels.size());
+	if (!file) {image.pixels.clear(); return false; /* Truncated. */}
+	return true;
+}
+
+static void writeCache(const DecodedImage& image, int64_t time) {
+	std::filesystem::path path = cachePath(image.path);
+	std::filesystem::path temporary = path;
+	temporary += ".tmp";
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+
+	CacheHeader header;
+	header.sourceTime = time;
+	header.width = image.resolution.x;
+	header.height = image.resolution.y;
+	{
+		std::ofstream file(temporary, std::ios::binary);
+		if (!file) {return; /* Caching is optional. */}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(image.pixels.data()), image.pixels.size());
+		if (!file) {return;}
+	}
+	std::filesystem::rename(temporary, path, error); //Never leave a half-written cache behind.
+}
+//// DISK CACHE ////
+
+
+
+static void decode(DecodedImage& image) {
+	//Worker thread.
+	PROFILE_SCOPE("Decode texture");
+	int64_t time = sourceTime(image.path);
+	if ((time == -1) || !readCache(image, time)) {
+		int width, height, channels;
+		unsigned char* textureData = stbi_load(
+			image.path.c_str(),
+			&width, &height,
+			&channels, 4 //RGBA, 4 channels.
+		);
+		if (textureData) {
+			image.resolution = glm::ivec2(width, height);
+			image.pixels.assign(textureData, textureData + (static_cast<size_t>(width) * height * 4u));
+			stbi_image_free(textureData);
+			if (time != -1) {writeCache(image, time);}
+		}
+	}
+
+	if (
+		image.pixels.empty() ||
+		((image.expectedRes.x != -1) && (image.resolution.x != image.expectedRes.x)) ||
+		((image.expectedRes.y != -1) && (image.resolution.y != image.expectedRes.y))
+	) { //Could not find, or was wrong res. Keeps the placeholder.
+		std::cerr << "Failed to load texture : [" << image.path << "] : Image was not found/correct resolution." << std::endl;
+		std::cerr << "Expected [" << image.expectedRes.x << ", " << image.expectedRes.y << "] : Got [" << image.resolution.x << ", " << image.resolution.y << "]" << std::endl;
+		image.pixels.clear();
+	}
+}
+
+static void queueDecode(GLuint textureID, int layer, std::string path, glm::ivec2 expectedRes) {
+	inFlight++;
+	threading::workers().submit([textureID, layer, path = std::move(path), expectedRes]() {
+		DecodedImage image{textureID, layer, path, expectedRes};
+		decode(image);
+		std::lock_guard<std::mutex> lock(readyMutex);
+		ready.push_back(std::move(image));
+	});
+}
+
+
+
+static void upload(DecodedImage& image) {
+	size_t size = image.pixels.size();
+	GLuint& PBO = uploadPBOs[uploadIndex];
+	uploadIndex = (uploadIndex + 1u) % uploadPBOs.size();
+	if (!PBO) {glGenBuffers(1, &PBO);}
+
+	//Orphan the old storage, so a copy still reading it does not stall the map.
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, PBO);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mapped) {
+		std::memcpy(mapped, image.pixels.data(), size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		if (image.layer == -1) {
+			glBindTexture(GL_TEXTURE_2D, image.textureID);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.resolution.x, image.resolution.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); //From the PBO.
+			glBindTexture(GL_TEXTURE_2D, 0);
+		} else {
+			glBindTexture(GL_TEXTURE_2D_ARRAY, image.textureID);
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, image.layer, image.resolution.x, image.resolution.y, 1, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); //From the PBO.
+			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		}
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+static bool uploadNext() {
+	DecodedImage image;
+	{
+		std::lock_guard<std::mutex> lock(readyMutex);
+		if (ready.empty()) {return false;}
+		image = std::move(ready.front());
+		ready.pop_front();
+	}
+	if (!image.pixels.empty() && glIsTexture(image.textureID)) {upload(image); /* Skipped if deleted while decoding. */}
+	inFlight--;
+	return true;
+}
+
+
+
+
+namespace textures {
+
+GLuint request2D(const std::string& textureName, glm::ivec2 expectedRes) {
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+
+	//1x1 placeholder, replaced (and resized) once uploaded.
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, display::TEXTURE_PLACEHOLDER_COLOUR.data());
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	queueDecode(textureID, -1, "textures/" + textureName + ".png", expectedRes);
+	return textureID;
+}
+
+
+GLuint request2DArray(const std::vector<std::string>& textureNames, glm::ivec2 expectedRes) {
+	GLuint sheetArrayID;
+	glGenTextures(1, &sheetArrayID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, sheetArrayID);
+
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, expectedRes.x, expectedRes.y, textureNames.size());
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT); //Textures repeat UV.
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT); // ^ ^ ^ ^ ^ ^ ^ ^ ^
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE); //Clamp to nearest layer
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	//Every layer starts as the placeholder, without building an image on the CPU.
+	glClearTexImage(sheetArrayID, 0, GL_RGBA, GL_UNSIGNED_BYTE, display::TEXTURE_PLACEHOLDER_COLOUR.data());
+
+	for (size_t layerIndex=0; layerIndex<textureNames.size(); layerIndex++) {
+		if (textureNames[layerIndex].empty()) {continue; /* Ignore blank entries. */}
+		queueDecode(sheetArrayID, static_cast<int>(layerIndex), "textures/" + textureNames[layerIndex], expectedRes);
+	}
+
+	return sheetArrayID;
+}
+
+
+
+void update(double budgetMS) {
+	if (inFlight == 0u) {return;}
+	PROFILE_SCOPE("textures::update");
+	auto start = std::chrono::steady_clock::now();
+	while (uploadNext()) {
+		//Always uploads at least one, so a large image can not stall forever.
+		if (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= budgetMS) {break;}
+	}
+}
+
+
+size_t pending() {
+	return inFlight;
+}
+
+
+void finish() {
+	while (inFlight > 0u) {
+		if (!uploadNext()) {std::this_thread::yield(); /* Still decoding. */}
+	}
+}
+
+}
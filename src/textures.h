@@ -0,0 +1,23 @@
+#ifndef TEXTURES_H
+#define TEXTURES_H
+
+#include "includes.h"
+#include "constants.h"
+
+
+
+
+namespace textures {
+
+	//Both return immediately. The texture shows the placeholder colour until its PNGs are decoded (worker pool) and uploaded (update()).
+	GLuint request2D(const std::string& textureName, glm::ivec2 expectedRes=glm::ivec2(-1, -1)); //"textures/<name>.png"
+	GLuint request2DArray(const std::vector<std::string>& textureNames, glm::ivec2 expectedRes=display::TEXTURE_RESOLUTION); //"textures/<name>", one layer each. Blank names are skipped.
+
+	void update(double budgetMS=display::TEXTURE_UPLOAD_BUDGET_MS); //Upload decoded images through PBOs until the budget is spent. Call once per frame.
+	size_t pending(); //Images not yet uploaded.
+	void finish(); //Wait for every decode, then upload everything. For startup/headless, where stalling is fine.
+
+}
+
+
+#endif
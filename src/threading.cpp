@@ -0,0 +1,76 @@
+#include "coreincludes.h"
+#include "threading.h"
+#include "profiler.h"
+using namespace std;
+
+
+
+
+namespace threading {
+
+WorkerPool::WorkerPool(unsigned int threadCount) {
+	if (threadCount == 0u) {threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1u;}
+	threads.reserve(threadCount);
+	for (unsigned int index=0u; index<threadCount; index++) {
+		threads.emplace_back(&WorkerPool::work, this);
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	//Finishes every queued job first.
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+	for (std::thread& thread : threads) {thread.join();}
+}
+
+
+
+void WorkerPool::submit(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	jobAvailable.notify_one();
+}
+
+size_t WorkerPool::pending() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return jobs.size() + running;
+}
+
+void WorkerPool::wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	jobsDone.wait(lock, [this]() {return jobs.empty() && (running == 0u);});
+}
+
+
+
+void WorkerPool::work() {
+	profiler::nameThread("Worker");
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		jobAvailable.wait(lock, [this]() {return stopping || !jobs.empty();});
+		if (jobs.empty()) {return; /* Stopping, and nothing left to do. */}
+
+		std::function<void()> job = std::move(jobs.front());
+		jobs.pop_front();
+		running++;
+		lock.unlock();
+		{PROFILE_SCOPE("Job"); job();}
+		lock.lock();
+		running--;
+		if (jobs.empty() && (running == 0u)) {jobsDone.notify_all();}
+	}
+}
+
+
+
+WorkerPool& workers() {
+	static WorkerPool pool;
+	return pool;
+}
+
+}
@@ -0,0 +1,176 @@
+#ifndef THREADING_H
+#define THREADING_H
+
+#include "coreincludes.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+
+
+
+
+namespace threading {
+
+	//Fixed set of threads running queued jobs in FIFO order.
+	class WorkerPool {
+	public:
+		explicit WorkerPool(unsigned int threadCount=0u); //0 = One per core, less the main thread.
+		~WorkerPool();
+
+		void submit(std::function<void()> job);
+		size_t pending(); //Queued and running jobs.
+		void wait(); //Block until every job submitted so far has finished.
+		unsigned int size() const {return static_cast<unsigned int>(threads.size());}
+
+	private:
+		void work();
+
+		std::vector<std::thread> threads;
+		std::deque<std::function<void()>> jobs;
+		std::mutex mutex;
+		std::condition_variable jobAvailable, jobsDone;
+		size_t running = 0u;
+		bool stopping = false;
+	};
+
+
+	WorkerPool& workers(); //Shared pool, created on first use.
+
+
+
+	//Fixed capacity FIFO between threads. push() blocks while full (back-pressure), pop() while empty.
+	template<typename T>
+	class BoundedQueue {
+	public:
+		explicit BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+		bool push(T item) {
+			//False if the queue was closed.
+			std::unique_lock<std::mutex> lock(mutex);
+			notFull.wait(lock, [this]() {return closed || (items.size() < capacity);});
+			if (closed) {return false;}
+			items.push_back(std::move(item));
+			notEmpty.notify_one();
+			return true;
+		}
+
+		bool pop(T& item) {
+			//False once the queue is closed and empty.
+			std::unique_lock<std::mutex> lock(mutex);
+			notEmpty.wait(lock, [this]() {return closed || !items.empty();});
+			if (items.empty()) {return false;}
+			item = std::move(items.front());
+			items.pop_front();
+			notFull.notify_one();
+			return true;
+		}
+
+		void close() {
+			//Wakes everything. Items already queued can still be popped.
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+			notFull.notify_all();
+			notEmpty.notify_all();
+		}
+
+		size_t size() {
+			std::lock_guard<std::mutex> lock(mutex);
+			return items.size();
+		}
+
+	private:
+		std::deque<T> items;
+		size_t capacity;
+		std::mutex mutex;
+		std::condition_variable notFull, notEmpty;
+		bool closed = false;
+	};
+
+
+
+	//Lock-free hand-over of the latest value from one writer thread to one reader thread.
+	//Neither side ever waits; The reader skips any values published between its reads.
+	template<typename T>
+	class TripleBuffer {
+	public:
+		T& back() {return slots[backIndex];} //Writer only. Fill, then publish().
+		void publish() {
+			backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX;
+		}
+
+		bool acquire() {
+			//Reader only. True if front() changed.
+			if (!(middle.load(std::memory_order_acquire) & FRESH)) {return false;}
+			frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+			return true;
+		}
+		const T& front() const {return slots[frontIndex];} //Reader only. Valid until the next acquire().
+
+	private:
+		static constexpr unsigned int INDEX = 3u, FRESH = 4u;
+		std::array<T, 3> slots;
+		unsigned int backIndex = 0u, frontIndex = 1u;
+		std::atomic<unsigned int> middle = 2u; //Slot index, with FRESH set once published & unread.
+	};
+
+
+
+	//Fixed capacity, lock-free FIFO from any number of writer threads to one reader thread.
+	//Neither side ever waits; tryPush() fails while full, tryPop() while empty. Capacity is a power of 2.
+	template<typename T>
+	class MPSCQueue {
+	public:
+		explicit MPSCQueue(size_t capacity) : cells(std::bit_ceil(std::max<size_t>(capacity, 2u))), mask(cells.size() - 1u) {
+			for (size_t index=0; index<cells.size(); index++) {cells[index].sequence.store(index, std::memory_order_relaxed);}
+		}
+
+		bool tryPush(const T& item) {
+			//Any thread. Claims a cell, writes it, then marks it readable.
+			size_t position = tail.load(std::memory_order_relaxed);
+			while (true) {
+				Cell& cell = cells[position & mask];
+				size_t sequence = cell.sequence.load(std::memory_order_acquire);
+				intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+				if (difference == 0) {
+					if (tail.compare_exchange_weak(position, position + 1u, std::memory_order_relaxed)) {
+						cell.item = item;
+						cell.sequence.store(position + 1u, std::memory_order_release);
+						return true;
+					}
+				} else if (difference < 0) {
+					return false; //Full, the reader has not freed this cell yet.
+				} else {
+					position = tail.load(std::memory_order_relaxed); //Another writer took it.
+				}
+			}
+		}
+
+		bool tryPop(T& item) {
+			//Reader only.
+			Cell& cell = cells[head & mask];
+			if (cell.sequence.load(std::memory_order_acquire) != head + 1u) {return false; /* Empty, or still being written. */}
+			item = cell.item;
+			cell.sequence.store(head + mask + 1u, std::memory_order_release);
+			head++;
+			return true;
+		}
+
+		size_t capacity() const {return cells.size();}
+
+	private:
+		struct Cell {
+			std::atomic<size_t> sequence; //== position: free to write, == position + 1: readable.
+			T item;
+		};
+		std::vector<Cell> cells;
+		size_t mask;
+		alignas(64) std::atomic<size_t> tail = 0u; //Next position to write, shared by every writer.
+		alignas(64) size_t head = 0u; //Next position to read.
+	};
+
+}
+
+
+#endif
@@ -0,0 +1,106 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "graphics.h"
+#include "streaming.h"
+#include "trails.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Ship trails are a ring of position samples that only ever lives on the GPU;
+ - The SSBO (bindings::SHIP_TRAILS) is slot-major, sample[slot * shipCount + ship],
+   so one tick's samples for the whole fleet are contiguous.
+ - record() writes only that newest slot, straight into a persistently mapped stream
+   (streaming.cpp), then one GPU-side copy into the ring per tick.
+ - trail.vert walks back from the head slot, one instanced line strip per ship.
+Nothing is rebuilt on the CPU, however long the trails are.
+\* -------------------------------------------------------------------------------- */
+
+
+static trails::RingState ring = {0u, 0u, display::TRAIL_CAPACITY, 0u};
+static streaming::StreamBuffer newestSamples; //Staging for one slot.
+static time_t lastSample = 0;
+static unsigned int trailLength = display::TRAIL_LENGTH;
+static float trailFade = display::TRAIL_FADE;
+
+
+
+
+namespace trails {
+
+void initialise() {
+	setLength(data::trailLength); //From the data file.
+	setFade(data::trailFade);
+	ring.shipCount = static_cast<GLuint>(data::spacecraft.size());
+	newestSamples.create(GL_COPY_READ_BUFFER, static_cast<size_t>(ring.shipCount) * sizeof(glm::ivec2));
+	size_t size = std::max(static_cast<size_t>(ring.capacity) * ring.shipCount * sizeof(glm::ivec2), sizeof(glm::ivec2));
+
+	if (GLIndex::trailSSBO) {glDeleteBuffers(1, &GLIndex::trailSSBO);}
+	GLIndex::trailSSBO = graphics::createShaderStorageBufferObject(bindings::SHIP_TRAILS, size, GL_DYNAMIC_DRAW);
+	reset();
+}
+
+void release() {
+	newestSamples.destroy();
+}
+
+
+void record(time_t UTC) {
+	if (ring.shipCount == 0u) {return;}
+	if ((ring.filled > 0u) && ((UTC < lastSample) || (UTC - lastSample > static_cast<time_t>(ring.capacity) * sim::TRAIL_SAMPLE_INTERVAL))) {
+		reset(); //Time went backwards, or jumped past the whole history.
+	}
+	if ((ring.filled > 0u) && (UTC - lastSample < sim::TRAIL_SAMPLE_INTERVAL)) {return; /* Not due yet. */}
+
+	glm::ivec2* samples = newestSamples.map<glm::ivec2>();
+	for (size_t ship=0; ship<ring.shipCount; ship++) {
+		samples[ship] = data::spacecraft[ship].position;
+	}
+	newestSamples.commit();
+
+	ring.head = (ring.filled == 0u) ? 0u : ((ring.head + 1u) % ring.capacity);
+	ring.filled = std::min(ring.filled + 1u, ring.capacity);
+	lastSample = UTC;
+
+	size_t slotSize = static_cast<size_t>(ring.shipCount) * sizeof(glm::ivec2);
+	glBindBuffer(GL_COPY_READ_BUFFER, newestSamples.buffer());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, GLIndex::trailSSBO);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, newestSamples.offset(), ring.head * slotSize, slotSize); //Ordered on the GPU, never stalls.
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+
+void reset() {
+	ring.head = 0u;
+	ring.filled = 0u;
+	lastSample = 0;
+}
+
+
+RingState state() {
+	return ring;
+}
+
+
+
+void setLength(unsigned int samples) {
+	trailLength = std::clamp(samples, 2u, display::TRAIL_CAPACITY);
+}
+
+unsigned int length() {
+	return trailLength;
+}
+
+void setFade(float exponent) {
+	trailFade = std::max(exponent, 0.0f);
+}
+
+float fade() {
+	return trailFade;
+}
+
+}
@@ -0,0 +1,35 @@
+#ifndef TRAILS_H
+#define TRAILS_H
+
+#include "includes.h"
+#include "constants.h"
+
+
+
+
+namespace trails {
+
+	//Where the newest sample is, for the trail shader.
+	struct RingState {
+		GLuint head;		//Slot of the newest sample.
+		GLuint filled;		//Samples written since the last reset, at most capacity.
+		GLuint capacity;	//Slots per ship.
+		GLuint shipCount;
+	};
+
+
+	void initialise(); //Allocate the ring for data::spacecraft. Call after loading.
+	void release(); //Free the stream, while the context is still current.
+	void record(time_t UTC); //Append every ship's position, once per sim::TRAIL_SAMPLE_INTERVAL. Call after spacecraft::evaluate().
+	void reset(); //Forget the history, e.g. after a jump in sim time.
+	RingState state();
+
+	void setLength(unsigned int samples); //Samples drawn per trail, clamped to display::TRAIL_CAPACITY.
+	unsigned int length();
+	void setFade(float exponent);
+	float fade();
+
+}
+
+
+#endif
@@ -1,6 +1,7 @@
-#include "includes.h"
-#include "global.h"
+#include "coreincludes.h"
 #include "constants.h"
+#include "structs.h"
+#include "utils.h"
 using namespace std;
 using namespace glm;
 
@@ -1,9 +1,9 @@
 #ifndef UTILS_H
 #define UTILS_H
 
-#include "includes.h"
-#include "global.h"
+#include "coreincludes.h"
 #include "constants.h"
+#include "structs.h"
 #include <vector>
 #include <stdexcept>
 
@@ -92,18 +92,6 @@ namespace utils {
 		string pause;
 		std::cin >> pause;
 	}
-	static inline void GLErrorcheck(std::string location = "", bool shouldPause = false) {
-		GLenum GLError;
-		GLError = glGetError();
-		if (GLError != GL_NO_ERROR) {
-			if (!utils::isConsoleVisible()) {
-				utils::showConsole();
-			}
-			std::cerr << location << " | OpenGL error; " << GLError << std::endl;
-			if (shouldPause) {pause();}
-		}
-	}
-
 	std::string readFile(const std::string& filePath);
 
 	static inline std::string getTimestampStr() {
@@ -116,6 +104,19 @@ namespace utils {
 		return oss.str();
 	}
 
+	static inline std::string getTimestampStrPrecise() {
+		//As above, with milliseconds. [YYYYMMDDhhmmss.mmm]
+		std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+		time_t seconds = std::chrono::system_clock::to_time_t(now);
+		long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+		struct tm* timeinfo = localtime(&seconds);
+
+		std::ostringstream oss;
+		oss << std::put_time(timeinfo, "%Y%m%d%H%M%S") << "." << std::setw(3) << std::setfill('0') << ms;
+
+		return oss.str();
+	}
+
 	static time_t getTimestamp(bool useMultiplier=true) {
 		//Returns UTC timestamp
 		return time(nullptr) * ((useMultiplier) ? (sim::DEBUG_TIME_SCALING * simSpeed) : 1);
@@ -0,0 +1,198 @@
+#include "includes.h"
+#include "global.h"
+#include "utils.h"
+#include "streaming.h"
+#include "profiler.h"
+#include "viewports.h"
+using namespace std;
+using namespace glm;
+
+
+
+/* -------------------------------------------------------------------------------- *\
+Several camera views in one window, from the one evaluated state per frame;
+ - prepare() lays the views out in a grid, culls every body against each view on the
+   CPU, and writes each view's uniform block & visible body indices into two streams.
+ - Every instanced draw binds its program once, then per view only moves the viewport
+   and the uniform block range (bindings::VIEW_UNIFORMS) and draws its visible count.
+   The body SSBOs, trails & shaders are shared; N views cost N small draws, not N apps.
+ - Orbits are kept if their ring crosses the view, sprites if their disc overlaps it.
+   Rings centred on something fixed relative to the focus are listed apart (staticBase),
+   as they are drawn once into the view's cached orbit layer. [See layers.cpp]
+With one view (the default) it fills the render target and follows data::view.
+\* -------------------------------------------------------------------------------- */
+
+
+static std::vector<viewports::Viewport> viewportList = {{nullptr, glm::ivec2(0, 0), glm::ivec2(0, 0), 0, 0, 0}};
+static streaming::StreamBuffer uniformStream; //VIEWPORT_MAX blocks, uniformStride apart.
+static streaming::StreamBuffer visibleStream; //Per view; Visible orbits, then visible sprites.
+static size_t uniformStride = sizeof(viewports::ViewUniforms);
+static glm::ivec4 target = glm::ivec4(0); //GL viewport of the render target, restored by unbind().
+
+
+
+static void layOut(glm::ivec2 resolution) {
+	//Grid, filled row by row from the top left.
+	int count = static_cast<int>(viewportList.size());
+	int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+	int rows = (count + columns - 1) / columns;
+	int gap = (count > 1) ? display::VIEWPORT_GAP : 0;
+	glm::ivec2 cell = glm::max((resolution - (glm::ivec2(columns - 1, rows - 1) * gap)) / glm::ivec2(columns, rows), glm::ivec2(1, 1));
+	for (int index=0; index<count; index++) {
+		int column = index % columns, row = index / columns;
+		viewportList[index].origin = glm::ivec2(column * (cell.x + gap), resolution.y - ((row + 1) * cell.y) - (row * gap));
+		viewportList[index].size = cell;
+	}
+}
+
+
+static void cull(viewports::Viewport& viewport, const structs::CameraView& view, GLuint* visible, GLuint staticBase, GLuint spriteBase) {
+	//World space rectangle the view covers, with a margin for line widths.
+	glm::dvec2 focus = glm::dvec2(view.focusBody->position);
+	glm::dvec2 centre = glm::dvec2(view.offset + (viewport.size / 2));
+	double margin = static_cast<double>(display::VIEWPORT_CULL_MARGIN);
+	double scale = std::max(static_cast<double>(view.scale), 1.0e-12d);
+	glm::dvec2 minimum = focus + ((-centre - margin) / scale);
+	glm::dvec2 maximum = focus + ((glm::dvec2(viewport.size) - centre + margin) / scale);
+
+	auto nearest = [&](glm::dvec2 point) {glm::dvec2 delta = glm::clamp(point, minimum, maximum) - point; return std::sqrt(glm::dot(delta, delta));};
+	auto farthest = [&](glm::dvec2 point) {glm::dvec2 delta = glm::max(glm::abs(point - minimum), glm::abs(point - maximum)); return std::sqrt(glm::dot(delta, delta));};
+
+	static std::vector<GLuint> moving; //Rings whose centre moves relative to the focus, listed after the static ones.
+	moving.clear();
+	viewport.staticCount = 0;
+	viewport.spriteCount = 0;
+	for (size_t index=0; index<data::bodies.size(); index++) {
+		const structs::CelestialBody& body = data::bodies[index];
+		glm::dvec2 position = glm::dvec2(body.position);
+		if (nearest(position) <= static_cast<double>(body.radius)) {visible[spriteBase + viewport.spriteCount++] = static_cast<GLuint>(index);}
+		if (!body.hasParentBody || !body.parent) {continue; /* No orbit line. */}
+		glm::dvec2 parent = glm::dvec2(body.parent->position);
+		double radius = static_cast<double>(body.orbitalRadius);
+		if ((nearest(parent) > radius) || (farthest(parent) < radius)) {continue; /* Ring misses the view. */}
+
+		//Centred on the focus itself, or both are fixed roots (Stars).
+		bool fixed = (body.parent == view.focusBody) || (!body.parent->hasParentBody && !view.focusBody->hasParentBody);
+		if (fixed) {visible[staticBase + viewport.staticCount++] = static_cast<GLuint>(index);} else {moving.push_back(static_cast<GLuint>(index));}
+	}
+	viewport.orbitCount = static_cast<GLsizei>(moving.size());
+	std::copy(moving.begin(), moving.end(), visible + staticBase + viewport.staticCount);
+}
+
+
+
+
+namespace viewports {
+
+void initialise() {
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	alignment = std::max(alignment, 16);
+	uniformStride = ((sizeof(ViewUniforms) + alignment - 1u) / alignment) * alignment;
+	uniformStream.create(GL_UNIFORM_BUFFER, display::VIEWPORT_MAX * uniformStride);
+	visibleStream.create(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(data::bodies.size(), 1u) * 2u * display::VIEWPORT_MAX * sizeof(GLuint), bindings::VISIBLE_BODIES);
+}
+
+void release() {
+	uniformStream.destroy();
+	visibleStream.destroy();
+}
+
+
+void set(const std::vector<std::string>& viewNames) {
+	//By name (Case insensitive), or "all".
+	viewportList.clear();
+	for (const std::string& name : viewNames) {
+		bool found = false;
+		for (structs::CameraView& view : data::views) {
+			if ((utils::strToLower(name) != "all") && (utils::strToLower(view.name) != utils::strToLower(name))) {continue;}
+			if (viewportList.size() >= display::VIEWPORT_MAX) {break;}
+			viewportList.push_back({&view, glm::ivec2(0, 0), glm::ivec2(0, 0), 0, 0, 0});
+			found = true;
+		}
+		if (!found) {std::cerr << "No view named \"" << name << "\" (or over " << display::VIEWPORT_MAX << " views), skipped." << std::endl;}
+	}
+
+	if (viewportList.empty()) {
+		viewportList.push_back({nullptr, glm::ivec2(0, 0), glm::ivec2(0, 0), 0, 0, 0});
+	} else {
+		//The first follows [E]/[Q], starting on the first view named.
+		data::view = viewportList[0].view;
+		data::currentCameraViewIndex = static_cast<unsigned int>(data::view - data::views.data());
+		viewportList[0].view = nullptr;
+	}
+	std::cout << "Showing " << viewportList.size() << " view" << ((viewportList.size() == 1u) ? "" : "s") << "." << std::endl;
+}
+
+
+void prepare() {
+	PROFILE_SCOPE("viewports::prepare");
+	glGetIntegerv(GL_VIEWPORT, &target.x);
+	layOut(currentRenderResolution);
+
+	unsigned char* uniforms = static_cast<unsigned char*>(uniformStream.map());
+	GLuint* visible = visibleStream.map<GLuint>();
+	GLuint base = 0u;
+	for (size_t index=0; index<viewportList.size(); index++) {
+		Viewport& viewport = viewportList[index];
+		const structs::CameraView& camera = view(index);
+		GLuint staticBase = base, spriteBase = base + static_cast<GLuint>(data::bodies.size());
+		cull(viewport, camera, visible, staticBase, spriteBase);
+		base += 2u * static_cast<GLuint>(data::bodies.size());
+
+		ViewUniforms block;
+		block.projectionMatrix = glm::ortho(0.0f, float(viewport.size.x), 0.0f, float(viewport.size.y), -1.0f, 1.0f);
+		block.offset = camera.offset;
+		block.resolution = viewport.size;
+		block.focusIndex = static_cast<GLint>(camera.focusBody - data::bodies.data());
+		block.scaling = camera.scale;
+		block.orbitBase = staticBase + static_cast<GLuint>(viewport.staticCount);
+		block.spriteBase = spriteBase;
+		block.staticBase = staticBase;
+		std::memcpy(uniforms + (index * uniformStride), &block, sizeof(block));
+	}
+	uniformStream.commit();
+	visibleStream.commit();
+}
+
+
+size_t count() {
+	return viewportList.size();
+}
+
+const Viewport& get(size_t index) {
+	return viewportList[index];
+}
+
+structs::CameraView& view(size_t index) {
+	structs::CameraView* camera = viewportList[index].view;
+	return (camera) ? *camera : *data::view;
+}
+
+
+glm::ivec4 area() {
+	return target;
+}
+
+glm::ivec4 rectangle(size_t index) {
+	//Render pixels to the target's viewport, which may be scaled (window larger than the render resolution).
+	const Viewport& viewport = viewportList[index];
+	glm::dvec2 scale = glm::dvec2(target.z, target.w) / glm::dvec2(glm::max(currentRenderResolution, glm::ivec2(1, 1)));
+	glm::ivec2 origin = glm::ivec2(glm::dvec2(viewport.origin) * scale), end = glm::ivec2(glm::dvec2(viewport.origin + viewport.size) * scale);
+	return glm::ivec4(origin.x, origin.y, end.x - origin.x, end.y - origin.y);
+}
+
+
+void bind(size_t index, bool offscreen) {
+	glm::ivec4 pixels = rectangle(index);
+	glm::ivec2 corner = (offscreen) ? glm::ivec2(0, 0) : glm::ivec2(target.x, target.y);
+	glViewport(corner.x + pixels.x, corner.y + pixels.y, pixels.z, pixels.w);
+	glBindBufferRange(GL_UNIFORM_BUFFER, bindings::VIEW_UNIFORMS, uniformStream.buffer(), uniformStream.offset() + static_cast<GLintptr>(index * uniformStride), uniformStride); //Whole std140 block, padded.
+	profiler::countStateChanges(2u); //Viewport, uniform block.
+}
+
+void unbind() {
+	glViewport(target.x, target.y, target.z, target.w);
+}
+
+}
@@ -0,0 +1,49 @@
+#ifndef VIEWPORTS_H
+#define VIEWPORTS_H
+
+#include "includes.h"
+#include "constants.h"
+#include "global.h"
+
+
+
+
+namespace viewports {
+
+	//Per-view uniform block, "uniform View" in the vertex shaders (std140, binding bindings::VIEW_UNIFORMS).
+	struct ViewUniforms {
+		glm::mat4 projectionMatrix;	//Viewport pixels to clip space.
+		glm::ivec2 offset;			//Camera offset, in viewport pixels.
+		glm::ivec2 resolution;		//Viewport size.
+		GLint focusIndex;			//Body the view is centred on.
+		float scaling;
+		GLuint orbitBase;			//First of this view's visible moving orbits in bindings::VISIBLE_BODIES.
+		GLuint spriteBase;			//First of this view's visible sprites.
+		GLuint staticBase;			//First of this view's visible static orbits, drawn into the cached layer.
+	};
+
+	struct Viewport {
+		structs::CameraView* view;	//nullptr follows data::view ([E]/[Q]).
+		glm::ivec2 origin, size;	//Render pixels, bottom left.
+		GLsizei orbitCount, spriteCount; //Visible after culling, this frame. Orbits whose ring moves relative to the focus.
+		GLsizei staticCount;		//Visible orbits whose ring is fixed relative to the focus. [See layers.cpp]
+	};
+
+
+	void initialise(); //Allocate the per-view streams for data::bodies. Call after loading.
+	void release(); //Free the streams, while the context is still current.
+	void set(const std::vector<std::string>& viewNames); //Views shown side by side in a grid. Empty for one full screen view.
+
+	void prepare(); //Once per frame, after evaluating; Lays out, culls & uploads every view.
+	size_t count();
+	const Viewport& get(size_t index);
+	structs::CameraView& view(size_t index);
+	glm::ivec4 area(); //The render target's GL viewport, as of prepare().
+	glm::ivec4 rectangle(size_t index); //A view's pixels within area(); x, y, width, height.
+	void bind(size_t index, bool offscreen=false); //Viewport rectangle & its uniform block range, for the draws that follow. Offscreen; Into an area() sized texture.
+	void unbind(); //Back to the whole render target.
+
+}
+
+
+#endif